@@ -0,0 +1,133 @@
+/**
+ * @file SetArgsAllocations.cpp
+ * @author SEED264
+ * @brief Allocation counter for the argument pushing of the wrapper functions
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Replaces operator new and the Lua push API with counters, then calls
+ * wrapper functions with string arguments long enough to defeat the small
+ * string optimisation. Every call must push exactly as many values as it
+ * has arguments and must not allocate.
+ *
+ * Build without linking Lua, e.g.
+ *   g++ -std=c++17 -O2 -Iinclude -Iglm -I<lua include> bench/SetArgsAllocations.cpp
+ *
+ * Exit code is 0 when every case passes.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <aut/AUL_Wrapper.h>
+
+namespace {
+    size_t g_alloc_num = 0;
+    size_t g_push_num = 0;
+    int g_fail_num = 0;
+
+    template<typename Func>
+    void Run(const char *label, size_t expected_push_num, Func func) {
+        g_alloc_num = 0;
+        g_push_num = 0;
+        func();
+        bool ok = g_alloc_num == 0 && g_push_num == expected_push_num;
+        if (!ok)g_fail_num++;
+        std::printf("%-44s pushes %2zu/%2zu allocs %zu %s\n", label, g_push_num, expected_push_num,
+                    g_alloc_num, ok ? "ok" : "NG");
+    }
+}
+
+void* operator new(size_t size) {
+    g_alloc_num++;
+    void *p = std::malloc(size ? size : 1);
+    if (!p)throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+extern "C" {
+    // 関数の取得と呼び出しは何もしない
+    void lua_getfield(lua_State*, int, const char*) {}
+    void lua_settop(lua_State*, int) {}
+    void lua_call(lua_State*, int, int) {}
+    lua_Integer lua_tointeger(lua_State*, int) { return 0; }
+    lua_Number lua_tonumber(lua_State*, int) { return 0; }
+
+    void lua_pushinteger(lua_State*, lua_Integer) { g_push_num++; }
+    void lua_pushnumber(lua_State*, lua_Number) { g_push_num++; }
+    void lua_pushstring(lua_State*, const char*) { g_push_num++; }
+    void lua_pushlstring(lua_State*, const char*, size_t) { g_push_num++; }
+    void lua_pushboolean(lua_State*, int) { g_push_num++; }
+    void lua_pushlightuserdata(lua_State*, void*) { g_push_num++; }
+}
+
+int main() {
+    lua_State *L = nullptr;
+    const std::string font = "a font name longer than the sso buffer";
+    const std::string name = "a string argument longer than the sso buffer";
+
+    Run("effect(long name, 4 params)", 5, [&] {
+        aut::effect(L, "a long effect name for the benchmark", "range", 10, "fixed size", 1);
+    });
+    Run("setfont(std::string, 4 params)", 5, [&] {
+        aut::setfont(L, font, 34.0, 1, 0xffffff, 0x000000);
+    });
+    Run("setoption(\"drawtarget\", \"tempbuffer\", w, h)", 4, [&] {
+        aut::setoption(L, "drawtarget", "tempbuffer", 100, 100);
+    });
+    Run("filter(long name, 2 params)", 3, [&] {
+        aut::filter(L, "a_long_filter_name_for_the_benchmark", 1.0, 2.0);
+    });
+    Run("load(\"figure\", long name, 2 params)", 4, [&] {
+        aut::load(L, "figure", "a long figure name for the benchmark", 0xffffff, 100);
+    });
+    Run("getvalue(long target, t)", 2, [&] {
+        aut::getvalue(L, "layer1.a_long_target_name", 1.0);
+    });
+    Run("getvalue(track, t)", 2, [&] {
+        aut::getvalue(L, 0, 1.0);
+    });
+    Run("SetArgs(std::string lvalue x3)", 3, [&] {
+        if (aut::SetArgs(L, name, name, name) != 3)g_fail_num++;
+    });
+    Run("SetArgs()", 0, [&] {
+        if (aut::SetArgs(L) != 0)g_fail_num++;
+    });
+
+    return g_fail_num == 0 ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file AUL_Accumulation.h
+ * @author SEED264
+ * @brief Weighted accumulation of frames
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_ACCUMULATION_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_ACCUMULATION_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "./AUL_Parallel.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Buffer summing weighted images (e.g. subframes for motion blur)
+     *
+     * Channels are accumulated premultiplied by alpha in separate planes
+     * of Channel (unsigned short or float), with the SIMD layer and in
+     * parallel. Resolve divides by the accumulated alpha, so transparent
+     * subframes do not darken the result. The planes only grow, so the
+     * memory footprint stays stable across frames.
+     *
+     * With unsigned short the accumulators are fixed point scaled so that
+     * max_total_weight (given to Reset) fills the 16-bit range; adding
+     * more weight than that saturates.
+     */
+    template<typename Channel>
+    class AccumulationBuffer {
+        static_assert(std::is_same<Channel, unsigned short>::value || std::is_same<Channel, float>::value,
+                      "Channel must be unsigned short or float");
+
+    public:
+        AccumulationBuffer();
+
+        /**
+         * Clear the buffer for a new image
+         *
+         * @param[in] size Image size
+         * @param[in] max_total_weight Sum of the weights that will be added
+         *            (only used for 16-bit accumulators)
+         */
+        void Reset(Size2D size, float max_total_weight = 1);
+        /**
+         * Add src multiplied by weight
+         *
+         * @param[in] src Pixel data (GetSize(), packed)
+         * @param[in] weight Weight of this image
+         */
+        void Add(const PixelRGBA *src, float weight = 1);
+        /**
+         * Write the weighted average to dst
+         *
+         * @param[out] dst Pixel data (GetSize(), packed)
+         */
+        void Resolve(PixelRGBA *dst) const;
+        Size2D GetSize() const;
+        float TotalWeight() const;
+
+    private:
+        static constexpr size_t kGrain = 16384;
+
+        size_t PlaneSize() const;
+
+        Size2D size_;
+        float total_weight_;
+        // 16ビットの場合の固定小数点のスケール (アルファ用と乗算済みの色用)
+        float alpha_scale_, color_scale_;
+        // b, g, r, aの順に並べた平面
+        std::vector<Channel> planes_;
+    };
+
+    using AccumulationBuffer16 = AccumulationBuffer<unsigned short>;
+    using AccumulationBuffer32F = AccumulationBuffer<float>;
+
+    namespace detail {
+        inline simd::VFloat LoadAccum(const float *src) {
+            return simd::Load(src);
+        }
+        inline simd::VFloat LoadAccum(const unsigned short *src) {
+            return simd::LoadU16(src);
+        }
+        inline void StoreAccum(float *dst, simd::VFloat v) {
+            simd::Store(dst, v);
+        }
+        inline void StoreAccum(unsigned short *dst, simd::VFloat v) {
+            simd::StoreU16(dst, v);
+        }
+    }
+}
+
+template<typename Channel>
+inline aut::AccumulationBuffer<Channel>::AccumulationBuffer()
+    : size_(), total_weight_(0), alpha_scale_(1), color_scale_(1) {}
+
+template<typename Channel>
+inline void aut::AccumulationBuffer<Channel>::Reset(Size2D size, float max_total_weight) {
+    size_ = size;
+    total_weight_ = 0;
+    if (std::is_same<Channel, unsigned short>::value) {
+        float w = std::max(max_total_weight, 1e-6f);
+        alpha_scale_ = 65535.f / (255.f * w);
+        color_scale_ = 65535.f / (255.f * 255.f * w);
+    } else {
+        alpha_scale_ = 1;
+        color_scale_ = 1;
+    }
+    size_t plane = PlaneSize();
+    if (planes_.size() < plane * 4)planes_.resize(plane * 4);
+    std::fill(planes_.begin(), planes_.begin() + plane * 4, Channel(0));
+}
+
+template<typename Channel>
+inline void aut::AccumulationBuffer<Channel>::Add(const PixelRGBA *src, float weight) {
+    using namespace simd;
+    if (weight <= 0)return;
+    total_weight_ += weight;
+    size_t n = static_cast<size_t>(size_.w) * size_.h, plane = PlaneSize();
+    Channel *pb = planes_.data(), *pg = pb + plane, *pr = pg + plane, *pa = pr + plane;
+    VFloat wa = Set1(weight * alpha_scale_), wc = Set1(weight * color_scale_);
+    ParallelFor(0, (n + kGrain - 1) / kGrain, [&](size_t chunk) {
+        size_t first = chunk * kGrain, last = std::min(first + kGrain, n);
+        for (size_t i = first; i < last; i += kLanes) {
+            VFloat b, g, r, a;
+            if (i + kLanes <= last) {
+                LoadPixels(src + i, &b, &g, &r, &a);
+            } else {
+                // 端数は透明で埋めて読む (平面は8の倍数まで確保してある)
+                PixelRGBA tail[kLanes];
+                std::copy(src + i, src + last, tail);
+                LoadPixels(tail, &b, &g, &r, &a);
+            }
+            VFloat m = a * wc;
+            detail::StoreAccum(pb + i, detail::LoadAccum(pb + i) + b * m);
+            detail::StoreAccum(pg + i, detail::LoadAccum(pg + i) + g * m);
+            detail::StoreAccum(pr + i, detail::LoadAccum(pr + i) + r * m);
+            detail::StoreAccum(pa + i, detail::LoadAccum(pa + i) + a * wa);
+        }
+    });
+}
+
+template<typename Channel>
+inline void aut::AccumulationBuffer<Channel>::Resolve(PixelRGBA *dst) const {
+    using namespace simd;
+    size_t n = static_cast<size_t>(size_.w) * size_.h, plane = PlaneSize();
+    if (total_weight_ <= 0) {
+        std::fill(dst, dst + n, PixelRGBA());
+        return;
+    }
+    const Channel *pb = planes_.data(), *pg = pb + plane, *pr = pg + plane, *pa = pr + plane;
+    // a = alpha / (alpha_scale * W)、色 = color / (color_scale * W) / a
+    VFloat inv_a = Set1(1.f / (alpha_scale_ * total_weight_));
+    VFloat inv_c = Set1(1.f / (color_scale_ * total_weight_));
+    VFloat zero = Set1(0.f), tiny = Set1(1e-6f);
+    ParallelFor(0, (n + kGrain - 1) / kGrain, [&](size_t chunk) {
+        size_t first = chunk * kGrain, last = std::min(first + kGrain, n);
+        for (size_t i = first; i < last; i += kLanes) {
+            VFloat a = detail::LoadAccum(pa + i) * inv_a;
+            VFloat k = inv_c / Max(a, tiny);
+            VMask visible = a > zero;
+            VFloat b = Select(visible, detail::LoadAccum(pb + i) * k, zero);
+            VFloat g = Select(visible, detail::LoadAccum(pg + i) * k, zero);
+            VFloat r = Select(visible, detail::LoadAccum(pr + i) * k, zero);
+            if (i + kLanes <= last) {
+                StorePixels(dst + i, b, g, r, a);
+            } else {
+                PixelRGBA tail[kLanes];
+                StorePixels(tail, b, g, r, a);
+                std::copy(tail, tail + (last - i), dst + i);
+            }
+        }
+    });
+}
+
+template<typename Channel>
+inline aut::Size2D aut::AccumulationBuffer<Channel>::GetSize() const {
+    return size_;
+}
+
+template<typename Channel>
+inline float aut::AccumulationBuffer<Channel>::TotalWeight() const {
+    return total_weight_;
+}
+
+template<typename Channel>
+inline size_t aut::AccumulationBuffer<Channel>::PlaneSize() const {
+    size_t n = static_cast<size_t>(size_.w) * size_.h;
+    return (n + simd::kLanes - 1) / simd::kLanes * simd::kLanes;
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_ACCUMULATION_H_
@@ -0,0 +1,238 @@
+/**
+ * @file AUL_Binding.h
+ * @author SEED264
+ * @brief Compile-time binding between structs and Lua tables
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_BINDING_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_BINDING_H_
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <lua.hpp>
+#include "./AUL_Type.h"
+
+/**
+ * Declare a field of a struct for TableBinding
+ * The field name is also used as the key of the table.
+ */
+#define AUT_BIND_FIELD(type, field) ::aut::BindField(#field, &type::field)
+
+namespace aut {
+    // 構造体のメンバーとテーブルのキーの対応
+    template<typename Struct, typename Member>
+    struct FieldBinding {
+        const char *name;
+        Member Struct::*member;
+    };
+
+    template<typename Struct, typename Member>
+    constexpr FieldBinding<Struct, Member> BindField(const char *name, Member Struct::*member) {
+        return { name, member };
+    }
+
+    /**
+     * Fields of a struct exchanged with Lua tables
+     * Specialize this with a static constexpr kFields tuple made of
+     * AUT_BIND_FIELD entries. Members must be arithmetic types.
+     */
+    template<typename T>
+    struct TableBinding;
+
+    /**
+     * Read a struct from a table
+     * Keys are pushed from a table of pre-interned strings kept in the
+     * registry, and fields are read with raw access (no metamethods).
+     * Missing fields become 0.
+     *
+     * @param[in] table_index Stack index of the table
+     * @param[out] out Destination struct
+     *
+     * @return bool false if the value at table_index is not a table
+     */
+    template<typename T>
+    bool ReadTable(lua_State *L, int table_index, T *out);
+    /**
+     * Write every field of a struct into an existing table with raw access
+     *
+     * @param[in] table_index Stack index of the table
+     * @param[in] value Source struct
+     */
+    template<typename T>
+    void WriteTable(lua_State *L, int table_index, const T &value);
+    /**
+     * Push a new table holding every field of a struct
+     *
+     * @param[in] value Source struct
+     */
+    template<typename T>
+    void PushTable(lua_State *L, const T &value);
+
+    template<>
+    struct TableBinding<CameraParam> {
+        static constexpr auto kFields = std::make_tuple(
+            AUT_BIND_FIELD(CameraParam, x), AUT_BIND_FIELD(CameraParam, y), AUT_BIND_FIELD(CameraParam, z),
+            AUT_BIND_FIELD(CameraParam, tx), AUT_BIND_FIELD(CameraParam, ty), AUT_BIND_FIELD(CameraParam, tz),
+            AUT_BIND_FIELD(CameraParam, rz),
+            AUT_BIND_FIELD(CameraParam, ux), AUT_BIND_FIELD(CameraParam, uy), AUT_BIND_FIELD(CameraParam, uz),
+            AUT_BIND_FIELD(CameraParam, d));
+    };
+
+    template<>
+    struct TableBinding<Size2D> {
+        static constexpr auto kFields = std::make_tuple(
+            AUT_BIND_FIELD(Size2D, w), AUT_BIND_FIELD(Size2D, h));
+    };
+
+    template<>
+    struct TableBinding<PixelCol> {
+        static constexpr auto kFields = std::make_tuple(
+            AUT_BIND_FIELD(PixelCol, col), AUT_BIND_FIELD(PixelCol, a));
+    };
+
+    template<>
+    struct TableBinding<PixelYC> {
+        static constexpr auto kFields = std::make_tuple(
+            AUT_BIND_FIELD(PixelYC, y), AUT_BIND_FIELD(PixelYC, cb),
+            AUT_BIND_FIELD(PixelYC, cr), AUT_BIND_FIELD(PixelYC, a));
+    };
+
+    namespace detail {
+        // レジストリ上のキー文字列テーブルを識別するためのアドレス
+        template<typename T>
+        inline char binding_keys_tag = 0;
+
+        // 負の相対位置を絶対位置に直す (疑似インデックスはそのまま)
+        inline int AbsIndex(lua_State *L, int index) {
+            return index < 0 && index > LUA_REGISTRYINDEX ? lua_gettop(L) + 1 + index : index;
+        }
+
+        /**
+         * Push the table of interned keys of T (created on first use)
+         */
+        template<typename T>
+        void PushBindingKeys(lua_State *L);
+        template<typename Tuple, typename Func, size_t... I>
+        void ForEachField(const Tuple &fields, Func func, std::index_sequence<I...>);
+        template<typename T, typename Func>
+        void ForEachField(Func func);
+
+        template<typename M>
+        void ToMember(lua_State *L, int index, M *out);
+        template<typename M>
+        void PushMember(lua_State *L, M value);
+    }
+}
+
+template<typename Tuple, typename Func, size_t... I>
+inline void aut::detail::ForEachField(const Tuple &fields, Func func, std::index_sequence<I...>) {
+    (func(std::get<I>(fields), static_cast<int>(I) + 1), ...);
+}
+
+template<typename T, typename Func>
+inline void aut::detail::ForEachField(Func func) {
+    constexpr auto &fields = TableBinding<T>::kFields;
+    ForEachField(fields, func,
+                 std::make_index_sequence<std::tuple_size<std::decay_t<decltype(fields)>>::value>());
+}
+
+template<typename T>
+inline void aut::detail::PushBindingKeys(lua_State *L) {
+    lua_pushlightuserdata(L, &binding_keys_tag<T>);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+    if (lua_type(L, -1) == LUA_TTABLE)return;
+    lua_pop(L, 1);
+    constexpr int n = static_cast<int>(std::tuple_size<std::decay_t<decltype(TableBinding<T>::kFields)>>::value);
+    lua_createtable(L, n, 0);
+    ForEachField<T>([&](const auto &field, int i) {
+        lua_pushstring(L, field.name);
+        lua_rawseti(L, -2, i);
+    });
+    lua_pushlightuserdata(L, &binding_keys_tag<T>);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+}
+
+template<typename M>
+inline void aut::detail::ToMember(lua_State *L, int index, M *out) {
+    static_assert(std::is_arithmetic<M>::value, "TableBinding members must be arithmetic");
+    if (std::is_floating_point<M>::value)
+        *out = static_cast<M>(lua_tonumber(L, index));
+    else
+        *out = static_cast<M>(lua_tointeger(L, index));
+}
+
+template<typename M>
+inline void aut::detail::PushMember(lua_State *L, M value) {
+    static_assert(std::is_arithmetic<M>::value, "TableBinding members must be arithmetic");
+    if (std::is_floating_point<M>::value)
+        lua_pushnumber(L, static_cast<lua_Number>(value));
+    else
+        lua_pushinteger(L, static_cast<lua_Integer>(value));
+}
+
+template<typename T>
+inline bool aut::ReadTable(lua_State *L, int table_index, T *out) {
+    table_index = detail::AbsIndex(L, table_index);
+    if (lua_type(L, table_index) != LUA_TTABLE)return false;
+    detail::PushBindingKeys<T>(L);
+    int keys = lua_gettop(L);
+    detail::ForEachField<T>([&](const auto &field, int i) {
+        lua_rawgeti(L, keys, i);
+        lua_rawget(L, table_index);
+        detail::ToMember(L, -1, &(out->*field.member));
+        lua_pop(L, 1);
+    });
+    lua_pop(L, 1);
+    return true;
+}
+
+template<typename T>
+inline void aut::WriteTable(lua_State *L, int table_index, const T &value) {
+    table_index = detail::AbsIndex(L, table_index);
+    detail::PushBindingKeys<T>(L);
+    int keys = lua_gettop(L);
+    detail::ForEachField<T>([&](const auto &field, int i) {
+        lua_rawgeti(L, keys, i);
+        detail::PushMember(L, value.*field.member);
+        lua_rawset(L, table_index);
+    });
+    lua_pop(L, 1);
+}
+
+template<typename T>
+inline void aut::PushTable(lua_State *L, const T &value) {
+    constexpr int n = static_cast<int>(std::tuple_size<std::decay_t<decltype(TableBinding<T>::kFields)>>::value);
+    lua_createtable(L, 0, n);
+    WriteTable(L, -1, value);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_BINDING_H_
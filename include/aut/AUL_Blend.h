@@ -0,0 +1,225 @@
+/**
+ * @file AUL_Blend.h
+ * @author SEED264
+ * @brief Blend-mode compositing of pixel buffers
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_BLEND_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_BLEND_H_
+
+#include <algorithm>
+#include <cstddef>
+#include "./AUL_Enum.h"
+#include "./AUL_Parallel.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Composite src onto dst
+     *
+     * kAutBlendNormal mixes dst toward src (alpha included) by the opacity,
+     * like a crossfade. kAutBlendAlphaOver is the Porter-Duff "over".
+     * The other modes blend the colors with the separable blend function of
+     * the mode and composite the result "over" dst.
+     * Rows are processed in parallel bands.
+     *
+     * @param[in,out] dst Destination pixels
+     * @param[in] dst_stride Number of pixels per row of dst
+     * @param[in] src Source pixels
+     * @param[in] src_stride Number of pixels per row of src
+     * @param[in] size Size of the area to composite
+     * @param[in] mode Blend mode
+     * @param[in] opacity Opacity of src (0.0 ~ 1.0)
+     * @param[in] mask Per-pixel opacity multiplier (0 ~ 255, size.w per row, null = none)
+     * @param[in] premultiplied Whether both buffers store premultiplied colors
+     */
+    void Composite(PixelRGBA *dst, size_t dst_stride, const PixelRGBA *src, size_t src_stride,
+                   Size2D size, BlendMode mode, float opacity = 1, const byte *mask = nullptr,
+                   bool premultiplied = false);
+    /**
+     * Composite src onto dst (both packed, same size)
+     *
+     * @param[in,out] dst Destination pixels
+     * @param[in] src Source pixels
+     * @param[in] size Image size
+     * @param[in] mode Blend mode
+     * @param[in] opacity Opacity of src (0.0 ~ 1.0)
+     * @param[in] mask Per-pixel opacity multiplier (0 ~ 255, null = none)
+     * @param[in] premultiplied Whether both buffers store premultiplied colors
+     */
+    void Composite(PixelRGBA *dst, const PixelRGBA *src, Size2D size, BlendMode mode,
+                   float opacity = 1, const byte *mask = nullptr, bool premultiplied = false);
+
+    namespace detail {
+        template<BlendMode Mode>
+        simd::VFloat BlendChannel(simd::VFloat cb, simd::VFloat cs);
+        template<BlendMode Mode>
+        void CompositePixels(PixelRGBA *dst, const PixelRGBA *src, const byte *mask,
+                             float opacity, bool premultiplied);
+        template<BlendMode Mode>
+        void CompositeRows(PixelRGBA *dst, size_t dst_stride, const PixelRGBA *src, size_t src_stride,
+                           Size2D size, float opacity, const byte *mask, bool premultiplied);
+    }
+}
+
+template<aut::BlendMode Mode>
+inline aut::simd::VFloat aut::detail::BlendChannel(simd::VFloat cb, simd::VFloat cs) {
+    using namespace simd;
+    const VFloat zero = Set1(0.f), one = Set1(1.f);
+    switch (Mode) {
+    case kAutBlendAdd:
+        return Min(cb + cs, one);
+    case kAutBlendSubtract:
+        return Max(cb - cs, zero);
+    case kAutBlendMultiply:
+        return cb * cs;
+    case kAutBlendScreen:
+        return cb + cs - cb * cs;
+    case kAutBlendOverlay:
+        return Select(Set1(0.5f) >= cb, Set1(2.f) * cb * cs,
+                      one - Set1(2.f) * (one - cb) * (one - cs));
+    case kAutBlendLighten:
+        return Max(cb, cs);
+    case kAutBlendDarken:
+        return Min(cb, cs);
+    default:
+        return cs;
+    }
+}
+
+template<aut::BlendMode Mode>
+inline void aut::detail::CompositePixels(PixelRGBA *dst, const PixelRGBA *src, const byte *mask,
+                                         float opacity, bool premultiplied) {
+    using namespace simd;
+    const VFloat zero = Set1(0.f), one = Set1(1.f), inv255 = Set1(1.f / 255), v255 = Set1(255.f);
+    VFloat d[4], s[4];
+    LoadPixels(dst, &d[0], &d[1], &d[2], &d[3]);
+    LoadPixels(src, &s[0], &s[1], &s[2], &s[3]);
+    for (int c = 0; c < 4; c++) {
+        d[c] = d[c] * inv255;
+        s[c] = s[c] * inv255;
+    }
+    VFloat f = Set1(opacity);
+    if (mask != nullptr)
+        f = f * LoadU8(mask) * inv255;
+    // 以降はプリマルチプライドで計算する
+    if (!premultiplied) {
+        for (int c = 0; c < 3; c++) {
+            d[c] = d[c] * d[3];
+            s[c] = s[c] * s[3];
+        }
+    }
+    VFloat out[4];
+    if (Mode == kAutBlendNormal) {
+        for (int c = 0; c < 4; c++) out[c] = d[c] + (s[c] * f - d[c] * f);
+    } else {
+        VFloat ab = d[3], as = s[3] * f;
+        VFloat inv_ab = one - ab, inv_as = one - as;
+        out[3] = as + ab * inv_as;
+        for (int c = 0; c < 3; c++) {
+            VFloat Cs = s[c] * f;
+            if (Mode == kAutBlendAlphaOver) {
+                out[c] = Cs + d[c] * inv_as;
+            } else {
+                VFloat cb = Select(ab > zero, d[c] / ab, zero);
+                VFloat cs = Select(s[3] > zero, s[c] / s[3], zero);
+                out[c] = Cs * inv_ab + d[c] * inv_as + as * ab * BlendChannel<Mode>(cb, cs);
+            }
+        }
+    }
+    if (!premultiplied) {
+        VFloat valid = Select(out[3] > zero, one / out[3], zero);
+        for (int c = 0; c < 3; c++) out[c] = out[c] * valid;
+    }
+    StorePixels(dst, out[0] * v255, out[1] * v255, out[2] * v255, out[3] * v255);
+}
+
+template<aut::BlendMode Mode>
+inline void aut::detail::CompositeRows(PixelRGBA *dst, size_t dst_stride,
+                                       const PixelRGBA *src, size_t src_stride,
+                                       Size2D size, float opacity, const byte *mask,
+                                       bool premultiplied) {
+    const size_t kBand = 16;
+    const size_t band_num = (size.h + kBand - 1) / kBand;
+    ParallelFor(0, band_num, [&](size_t band) {
+        size_t y_end = std::min<size_t>((band + 1) * kBand, size.h);
+        for (size_t y = band * kBand; y < y_end; y++) {
+            PixelRGBA *d = dst + y * dst_stride;
+            const PixelRGBA *s = src + y * src_stride;
+            const byte *m = mask != nullptr ? mask + y * size.w : nullptr;
+            size_t x = 0;
+            for (; x + simd::kLanes <= size.w; x += simd::kLanes) {
+                CompositePixels<Mode>(d + x, s + x, m != nullptr ? m + x : nullptr,
+                                      opacity, premultiplied);
+            }
+            if (x < size.w) {
+                // 端数は一時領域に詰めて処理する
+                size_t n = size.w - x;
+                PixelRGBA td[simd::kLanes], ts[simd::kLanes];
+                byte tm[simd::kLanes] = {};
+                std::copy(d + x, d + size.w, td);
+                std::copy(s + x, s + size.w, ts);
+                if (m != nullptr)
+                    std::copy(m + x, m + size.w, tm);
+                CompositePixels<Mode>(td, ts, m != nullptr ? tm : nullptr, opacity, premultiplied);
+                std::copy(td, td + n, d + x);
+            }
+        }
+    });
+}
+
+inline void aut::Composite(PixelRGBA *dst, size_t dst_stride, const PixelRGBA *src, size_t src_stride,
+                           Size2D size, BlendMode mode, float opacity, const byte *mask,
+                           bool premultiplied) {
+    opacity = std::min(std::max(opacity, 0.f), 1.f);
+    switch (mode) {
+#define AUT_COMPOSITE_CASE(m) \
+    case m: \
+        detail::CompositeRows<m>(dst, dst_stride, src, src_stride, size, opacity, mask, premultiplied); \
+        break;
+    AUT_COMPOSITE_CASE(kAutBlendNormal)
+    AUT_COMPOSITE_CASE(kAutBlendAdd)
+    AUT_COMPOSITE_CASE(kAutBlendSubtract)
+    AUT_COMPOSITE_CASE(kAutBlendMultiply)
+    AUT_COMPOSITE_CASE(kAutBlendScreen)
+    AUT_COMPOSITE_CASE(kAutBlendOverlay)
+    AUT_COMPOSITE_CASE(kAutBlendLighten)
+    AUT_COMPOSITE_CASE(kAutBlendDarken)
+    AUT_COMPOSITE_CASE(kAutBlendAlphaOver)
+#undef AUT_COMPOSITE_CASE
+    }
+}
+
+inline void aut::Composite(PixelRGBA *dst, const PixelRGBA *src, Size2D size, BlendMode mode,
+                           float opacity, const byte *mask, bool premultiplied) {
+    Composite(dst, size.w, src, size.w, size, mode, opacity, mask, premultiplied);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_BLEND_H_
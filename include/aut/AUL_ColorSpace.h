@@ -0,0 +1,231 @@
+/**
+ * @file AUL_ColorSpace.h
+ * @author SEED264
+ * @brief sRGB <-> linear-light conversion
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_COLORSPACE_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_COLORSPACE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include "./AUL_Image.h"
+#include "./AUL_Parallel.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Decode an sRGB channel value to linear light
+     *
+     * @param[in] value sRGB value (0 ~ 255)
+     *
+     * @return float Linear value (0 ~ 1)
+     */
+    float SrgbToLinear(byte value);
+    /**
+     * Encode a linear-light value to sRGB
+     * The result is exactly round(encode(value) * 255).
+     *
+     * @param[in] value Linear value (clamped to 0 ~ 1)
+     *
+     * @return byte sRGB value (0 ~ 255)
+     */
+    byte LinearToSrgb(float value);
+    /**
+     * Convert pixels to linear light
+     * RGB is decoded, alpha is only normalized.
+     *
+     * @param[in] src sRGB pixels
+     * @param[out] dst Linear pixels
+     * @param[in] n Number of pixels
+     */
+    void DecodeSrgb(const PixelRGBA *src, PixelRGBA32F *dst, size_t n);
+    /**
+     * Convert linear-light pixels to sRGB
+     * RGB is encoded, alpha is only quantized.
+     *
+     * @param[in] src Linear pixels
+     * @param[out] dst sRGB pixels
+     * @param[in] n Number of pixels
+     */
+    void EncodeSrgb(const PixelRGBA32F *src, PixelRGBA *dst, size_t n);
+
+    // リニアの32bit浮動小数点数 (ホストとの変換時にsRGBをデコード/エンコードする)
+    struct FormatLinearRGBA32F {
+        using Pixel = PixelRGBA32F;
+        static PixelRGBA32F Load(const Pixel &p);
+        static Pixel Store(const PixelRGBA32F &c);
+        static void FromHost(const PixelRGBA *src, Pixel *dst, size_t n);
+        static void ToHost(const Pixel *src, PixelRGBA *dst, size_t n);
+    };
+    using ImageLinear = Image<FormatLinearRGBA32F>;
+
+    /**
+     * Apply func to every pixel in linear light
+     * Decode, func and encode are fused per strip of a row, so no full-size
+     * float buffer is allocated. func is called as
+     * func(PixelRGBA32F &color, unsigned int x, unsigned int y).
+     *
+     * @param[in,out] data Pixel data (e.g. of obj.getpixeldata)
+     * @param[in] size Image size
+     * @param[in] func Function applied to each pixel
+     */
+    template<typename Func>
+    void TransformLinear(PixelRGBA *data, Size2D size, Func func);
+
+    namespace detail {
+        struct SrgbTables {
+            static constexpr uint kEncodeSize = 4096;
+            float decode[256];
+            // 区間の先頭の値のコード
+            uint encode[kEncodeSize + 1];
+            // 各コードの次のコードになる値の下限
+            float threshold[256];
+
+            SrgbTables();
+        };
+        const SrgbTables& GetSrgbTables();
+        simd::VMask AlphaLanes();
+    }
+}
+
+inline aut::detail::SrgbTables::SrgbTables() {
+    auto decode_exact = [](double s) {
+        return s <= 0.04045 ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4);
+    };
+    auto encode_exact = [](double v) {
+        return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1 / 2.4) - 0.055;
+    };
+    for (int i = 0; i < 256; i++) {
+        decode[i] = static_cast<float>(decode_exact(i / 255.0));
+        if (i == 255) {
+            threshold[i] = std::numeric_limits<float>::infinity();
+            continue;
+        }
+        // floatに丸めた誤差で丸めの境界がずれないよう、最小のfloatに合わせる
+        const double boundary = (i + 0.5) / 255.0;
+        float t = static_cast<float>(decode_exact(boundary));
+        while (encode_exact(t) < boundary) t = std::nextafter(t, 2.f);
+        while (encode_exact(std::nextafter(t, -1.f)) >= boundary) t = std::nextafter(t, -1.f);
+        threshold[i] = t;
+    }
+    // 区間幅は暗部のしきい値の間隔より狭いので、各区間にしきい値は高々1つ
+    uint code = 0;
+    for (uint i = 0; i <= kEncodeSize; i++) {
+        float v = static_cast<float>(i) / kEncodeSize;
+        while (code < 255 && v >= threshold[code]) code++;
+        encode[i] = code;
+    }
+}
+
+inline const aut::detail::SrgbTables& aut::detail::GetSrgbTables() {
+    static const SrgbTables tables;
+    return tables;
+}
+
+inline aut::simd::VMask aut::detail::AlphaLanes() {
+    using namespace simd;
+    return (Iota(0u) & Set1(3u)) == Set1(3u);
+}
+
+inline float aut::SrgbToLinear(byte value) {
+    return detail::GetSrgbTables().decode[value];
+}
+
+inline aut::byte aut::LinearToSrgb(float value) {
+    const detail::SrgbTables &t = detail::GetSrgbTables();
+    value = std::min(std::max(value, 0.f), 1.f);
+    uint code = t.encode[static_cast<uint>(value * t.kEncodeSize)];
+    return static_cast<byte>(value >= t.threshold[code] ? code + 1 : code);
+}
+
+inline void aut::DecodeSrgb(const PixelRGBA *src, PixelRGBA32F *dst, size_t n) {
+    using namespace simd;
+    const detail::SrgbTables &t = detail::GetSrgbTables();
+    const VMask alpha = detail::AlphaLanes();
+    detail::ConvertChannels(reinterpret_cast<const byte*>(src), reinterpret_cast<float*>(dst), n * 4,
+        [&](const byte *s) {
+            VFloat v = LoadU8(s);
+            return Select(alpha, v * Set1(1.f / 255), Gather(t.decode, ToInt(v)));
+        },
+        [](float *d, VFloat v) { Store(d, v); });
+}
+
+inline void aut::EncodeSrgb(const PixelRGBA32F *src, PixelRGBA *dst, size_t n) {
+    using namespace simd;
+    const detail::SrgbTables &t = detail::GetSrgbTables();
+    const VMask alpha = detail::AlphaLanes();
+    const VFloat zero = Set1(0.f), one = Set1(1.f);
+    detail::ConvertChannels(reinterpret_cast<const float*>(src), reinterpret_cast<byte*>(dst), n * 4,
+        [&](const float *s) {
+            VFloat v = Min(Max(Load(s), zero), one);
+            VUInt code = Gather(t.encode, ToInt(v * Set1(static_cast<float>(t.kEncodeSize))));
+            VFloat rgb = ToFloat(code) + Select(v >= Gather(t.threshold, code), one, zero);
+            return Select(alpha, v * Set1(255.f), rgb);
+        },
+        [](byte *d, VFloat v) { StoreU8(d, v); });
+}
+
+inline aut::PixelRGBA32F aut::FormatLinearRGBA32F::Load(const Pixel &p) {
+    return p;
+}
+
+inline aut::PixelRGBA32F aut::FormatLinearRGBA32F::Store(const PixelRGBA32F &c) {
+    return c;
+}
+
+inline void aut::FormatLinearRGBA32F::FromHost(const PixelRGBA *src, Pixel *dst, size_t n) {
+    DecodeSrgb(src, dst, n);
+}
+
+inline void aut::FormatLinearRGBA32F::ToHost(const Pixel *src, PixelRGBA *dst, size_t n) {
+    EncodeSrgb(src, dst, n);
+}
+
+template<typename Func>
+inline void aut::TransformLinear(PixelRGBA *data, Size2D size, Func func) {
+    const size_t kStrip = 256;
+    ParallelFor(0, size.h, [&](size_t y) {
+        PixelRGBA32F strip[kStrip];
+        PixelRGBA *row = data + y * size.w;
+        for (size_t x0 = 0; x0 < size.w; x0 += kStrip) {
+            size_t n = std::min<size_t>(kStrip, size.w - x0);
+            DecodeSrgb(row + x0, strip, n);
+            for (size_t i = 0; i < n; i++) {
+                func(strip[i], static_cast<unsigned int>(x0 + i), static_cast<unsigned int>(y));
+            }
+            EncodeSrgb(strip, row + x0, n);
+        }
+    }, 8);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_COLORSPACE_H_
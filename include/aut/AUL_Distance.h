@@ -0,0 +1,205 @@
+/**
+ * @file AUL_Distance.h
+ * @author SEED264
+ * @brief Euclidean distance transform on alpha
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_DISTANCE_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_DISTANCE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "./AUL_Parallel.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Distance from each pixel to the nearest opaque pixel
+     * A pixel is opaque when its alpha is at least threshold, and the
+     * distance is measured between pixel centers (0 on opaque pixels).
+     * The cost is linear in the number of pixels, independent of distances.
+     *
+     * @param[out] dst Distances (same layout as src)
+     * @param[in] src Pixel data
+     * @param[in] size Image size
+     * @param[in] threshold Minimum alpha of opaque pixels
+     */
+    void DistanceTransform(float *dst, const PixelRGBA *src, Size2D size, byte threshold = 128);
+    /**
+     * Signed distance to the edge of the opaque area
+     * Positive outside, negative inside, and the edge lies halfway between
+     * an opaque pixel and a transparent one.
+     *
+     * @param[out] dst Signed distances (same layout as src)
+     * @param[in] src Pixel data
+     * @param[in] size Image size
+     * @param[in] threshold Minimum alpha of opaque pixels
+     */
+    void SignedDistanceTransform(float *dst, const PixelRGBA *src, Size2D size, byte threshold = 128);
+    /**
+     * Signed distance to the edge of the opaque area stored in 8 bits
+     * The edge maps to 128, range pixels inside to 255 and range pixels
+     * outside to 0.
+     *
+     * @param[out] dst Encoded distances (same layout as src)
+     * @param[in] src Pixel data
+     * @param[in] size Image size
+     * @param[in] range Distance mapped to both ends of the output
+     * @param[in] threshold Minimum alpha of opaque pixels
+     */
+    void SignedDistanceTransform(byte *dst, const PixelRGBA *src, Size2D size, float range,
+                                 byte threshold = 128);
+
+    namespace detail {
+        // 特徴画素がない場合の2乗距離 (infだと放物線の交点がNaNになる)
+        constexpr float kEdtInfinity = 1e20f;
+
+        /**
+         * Squared distance to the nearest pixel whose opacity equals opaque
+         * Columns are scanned in bands, then rows are processed with the
+         * lower envelope of parabolas (Felzenszwalb and Huttenlocher).
+         * The envelope is computed in double, because f + q * q exceeds the
+         * 2^24 range of exact integers in float at 4K sizes. Only the stored
+         * result is rounded to float (exact below 2^24, i.e. distance 4096).
+         */
+        void SquaredDistance(float *dst, const PixelRGBA *src, Size2D size, byte threshold, bool opaque);
+    }
+}
+
+inline void aut::detail::SquaredDistance(float *dst, const PixelRGBA *src, Size2D size, byte threshold,
+                                         bool opaque) {
+    const unsigned int w = size.w, h = size.h;
+    if (w == 0 || h == 0)return;
+    // 列方向: 行順に上下2回走査して同じ列の最寄りの特徴画素までの距離を求める
+    const size_t kBand = 256;
+    ParallelFor(0, (w + kBand - 1) / kBand, [&](size_t band) {
+        size_t x0 = band * kBand, x1 = std::min(x0 + kBand, static_cast<size_t>(w));
+        for (size_t y = 0; y < h; y++) {
+            const PixelRGBA *row = src + y * w;
+            float *out = dst + y * w;
+            const float *prev = y ? out - w : nullptr;
+            for (size_t x = x0; x < x1; x++) {
+                if ((row[x].a >= threshold) == opaque)
+                    out[x] = 0;
+                else
+                    out[x] = prev && prev[x] < kEdtInfinity ? prev[x] + 1 : kEdtInfinity;
+            }
+        }
+        for (size_t y = h - 1; y-- > 0;) {
+            float *out = dst + y * w;
+            const float *next = out + w;
+            for (size_t x = x0; x < x1; x++)
+                out[x] = std::min(out[x], next[x] + 1);
+        }
+        for (size_t y = 0; y < h; y++) {
+            float *out = dst + y * w;
+            for (size_t x = x0; x < x1; x++)
+                out[x] = out[x] < kEdtInfinity ? out[x] * out[x] : kEdtInfinity;
+        }
+    });
+    // 行方向: 放物線の下側包絡線
+    const unsigned int kRows = 16;
+    ParallelFor(0, (h + kRows - 1) / kRows, [&](size_t block) {
+        std::vector<double> f(w), z(w + 1);
+        std::vector<int> v(w);
+        unsigned int y0 = static_cast<unsigned int>(block) * kRows, y1 = std::min(y0 + kRows, h);
+        for (unsigned int y = y0; y < y1; y++) {
+            float *row = dst + static_cast<size_t>(y) * w;
+            std::copy(row, row + w, f.begin());
+            int k = 0;
+            v[0] = 0;
+            z[0] = -kEdtInfinity;
+            z[1] = kEdtInfinity;
+            auto intersect = [&](int q, int p) {
+                return ((f[q] + static_cast<double>(q) * q) - (f[p] + static_cast<double>(p) * p)) / (2.0 * (q - p));
+            };
+            for (int q = 1; q < static_cast<int>(w); q++) {
+                // z[0]は十分小さいのでkが負になることはない
+                double s = intersect(q, v[k]);
+                while (s <= z[k]) {
+                    k--;
+                    s = intersect(q, v[k]);
+                }
+                k++;
+                v[k] = q;
+                z[k] = s;
+                z[k + 1] = kEdtInfinity;
+            }
+            k = 0;
+            for (int q = 0; q < static_cast<int>(w); q++) {
+                while (z[k + 1] < q)k++;
+                double d = static_cast<double>(q - v[k]);
+                row[q] = static_cast<float>(std::min(d * d + f[v[k]], static_cast<double>(kEdtInfinity)));
+            }
+        }
+    });
+}
+
+inline void aut::DistanceTransform(float *dst, const PixelRGBA *src, Size2D size, byte threshold) {
+    detail::SquaredDistance(dst, src, size, threshold, true);
+    size_t n = static_cast<size_t>(size.w) * size.h;
+    ParallelFor(0, (n + 4095) / 4096, [&](size_t block) {
+        size_t i1 = std::min(block * 4096 + 4096, n);
+        for (size_t i = block * 4096; i < i1; i++)
+            dst[i] = std::sqrt(dst[i]);
+    });
+}
+
+inline void aut::SignedDistanceTransform(float *dst, const PixelRGBA *src, Size2D size, byte threshold) {
+    size_t n = static_cast<size_t>(size.w) * size.h;
+    std::vector<float> inside(n);
+    detail::SquaredDistance(dst, src, size, threshold, true);
+    detail::SquaredDistance(inside.data(), src, size, threshold, false);
+    ParallelFor(0, (n + 4095) / 4096, [&](size_t block) {
+        size_t i1 = std::min(block * 4096 + 4096, n);
+        for (size_t i = block * 4096; i < i1; i++) {
+            // どちらか一方は必ず0
+            dst[i] = dst[i] > 0 ? std::sqrt(dst[i]) - 0.5f : 0.5f - std::sqrt(inside[i]);
+        }
+    });
+}
+
+inline void aut::SignedDistanceTransform(byte *dst, const PixelRGBA *src, Size2D size, float range,
+                                         byte threshold) {
+    size_t n = static_cast<size_t>(size.w) * size.h;
+    std::vector<float> dist(n);
+    SignedDistanceTransform(dist.data(), src, size, threshold);
+    float scale = range > 0 ? 127.5f / range : 0;
+    ParallelFor(0, (n + 4095) / 4096, [&](size_t block) {
+        size_t i1 = std::min(block * 4096 + 4096, n);
+        for (size_t i = block * 4096; i < i1; i++) {
+            float v = 128.5f - dist[i] * scale;
+            dst[i] = static_cast<byte>(std::min(std::max(v, 0.f), 255.f));
+        }
+    });
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_DISTANCE_H_
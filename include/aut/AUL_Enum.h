@@ -46,7 +46,61 @@ namespace aut {
     // サンプリング関数のフィルターモード指定用列挙型
     enum SamplingFilterMode :int {
         kAutFilterNearest = 0,
-        kAutFilterLinear = 1
+        kAutFilterLinear = 1,
+        // Mipmapと組み合わせた時のみ有効、単独のバッファではバイリニアと同じ
+        kAutFilterTrilinear = 2
+    };
+
+    // 合成関数のブレンドモード指定用列挙型
+    enum BlendMode :int {
+        kAutBlendNormal = 0,
+        kAutBlendAdd = 1,
+        kAutBlendSubtract = 2,
+        kAutBlendMultiply = 3,
+        kAutBlendScreen = 4,
+        kAutBlendOverlay = 5,
+        kAutBlendLighten = 6,
+        kAutBlendDarken = 7,
+        kAutBlendAlphaOver = 8
+    };
+
+    // ミップマップ生成時の縮小フィルター指定用列挙型
+    enum MipmapDownsample :int {
+        kAutMipmapBox = 0,
+        kAutMipmapKaiser = 1
+    };
+
+    // モルフォロジー演算の種類指定用列挙型
+    enum MorphologyOp :int {
+        kAutMorphDilate = 0,
+        kAutMorphErode = 1,
+        kAutMorphOpen = 2,
+        kAutMorphClose = 3
+    };
+
+    // モルフォロジー演算の構造要素の形状指定用列挙型
+    enum MorphologyShape :int {
+        kAutShapeRect = 0,
+        // 正八角形で近似した円
+        kAutShapeDisc = 1
+    };
+
+    // NativeArrayの要素の型指定用列挙型
+    enum NativeArrayType :int {
+        kAutArrayFloat = 0,
+        kAutArrayDouble = 1,
+        kAutArrayInt32 = 2,
+        // Luaからは0xAARRGGBBの数値として読み書きする
+        kAutArrayPixel = 3
+    };
+
+    // 処理解像度の段階指定用列挙型
+    enum ProxyQuality :int {
+        kAutQualityFull = 0,
+        // 縦横1/2
+        kAutQualityHalf = 1,
+        // 縦横1/4
+        kAutQualityQuarter = 2
     };
 }
 
@@ -0,0 +1,239 @@
+/**
+ * @file AUL_Ffi.h
+ * @author SEED264
+ * @brief C ABI export layer for LuaJIT FFI
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_FFI_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_FFI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <lua.hpp>
+
+/**
+ * Attribute of the exported C functions
+ */
+#if defined(_WIN32)
+#define AUT_FFI_EXPORT extern "C" __declspec(dllexport)
+#else
+#define AUT_FFI_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+#define AUT_FFI_STRINGIFY_(...) #__VA_ARGS__
+#define AUT_FFI_STRINGIFY(x) AUT_FFI_STRINGIFY_(x)
+
+/**
+ * C declarations of the exported functions
+ *
+ * The same text is compiled here and handed to ffi.cdef, so the two can
+ * not drift apart. Images are tightly packed aut_pixel arrays (the layout
+ * of getpixeldata) and strides count pixels, matrices are 9 doubles in
+ * column-major order, and the
+ * enum arguments take the values of the aut::kAut... constants.
+ */
+#define AUT_FFI_DECLARATIONS \
+    typedef struct aut_pixel { uint8_t b, g, r, a; } aut_pixel; \
+    int aut_ffi_version(void); \
+    uint32_t aut_random_bits(int seed, int frame, uint32_t index); \
+    float aut_random_float(float st, float ed, int seed, int frame, uint32_t index); \
+    void aut_fill_random_bits(uint32_t *out, size_t count, int seed, int frame, uint32_t first_index); \
+    void aut_fill_random_float(float *out, size_t count, float st, float ed, int seed, int frame, \
+                               uint32_t first_index); \
+    float aut_fractal_noise2(float x, float y, int seed, int octaves, float frequency, float lacunarity, \
+                             float gain); \
+    float aut_fractal_noise3(float x, float y, float z, int seed, int octaves, float frequency, \
+                             float lacunarity, float gain); \
+    void aut_fill_noise2(float *out, uint32_t w, uint32_t h, double offset_x, double offset_y, int seed, \
+                         int octaves, float frequency, float lacunarity, float gain); \
+    void aut_fill_noise3(float *out, uint32_t w, uint32_t h, float z, double offset_x, double offset_y, \
+                         int seed, int octaves, float frequency, float lacunarity, float gain); \
+    double aut_catmull_rom(double t, double p0, double p1, double p2, double p3); \
+    aut_pixel aut_sample(const aut_pixel *src, uint32_t w, uint32_t h, float x, float y, int address, \
+                         int filter); \
+    void aut_warp(aut_pixel *dst, uint32_t dst_w, uint32_t dst_h, const aut_pixel *src, uint32_t src_w, \
+                  uint32_t src_h, const double *matrix, int address, int filter); \
+    void aut_composite(aut_pixel *dst, size_t dst_stride, const aut_pixel *src, size_t src_stride, \
+                       uint32_t w, uint32_t h, int mode, float opacity, const uint8_t *mask, \
+                       int premultiplied); \
+    void aut_morphology(aut_pixel *data, uint32_t w, uint32_t h, int op, int radius, int shape); \
+    void aut_signed_distance(float *dst, const aut_pixel *src, uint32_t w, uint32_t h, uint8_t threshold); \
+    int aut_native_array_view(void *array, void **data, size_t *length, size_t *stride, int *type);
+
+extern "C" {
+    AUT_FFI_DECLARATIONS
+}
+
+namespace aut {
+    /**
+     * Declarations to pass to ffi.cdef
+     */
+    constexpr const char kFfiCdef[] = AUT_FFI_STRINGIFY(AUT_FFI_DECLARATIONS);
+
+    /**
+     * Push kFfiCdef as a string on the top of the stack
+     * Scripts then call ffi.cdef with it and ffi.load the DLL, and can cast
+     * getpixeldata pointers to aut_pixel* to index them as cdata.
+     */
+    void PushFfiCdef(lua_State *L);
+}
+
+inline void aut::PushFfiCdef(lua_State *L) {
+    lua_pushlstring(L, kFfiCdef, sizeof(kFfiCdef) - 1);
+}
+
+// 関数の実体はAUT_FFI_IMPLEMENTATIONを定義した1つの翻訳単位でのみ生成する
+// (このヘッダーを最初にincludeする前に定義すること)
+#ifdef AUT_FFI_IMPLEMENTATION
+
+#include <glm/mat3x3.hpp>
+#include "./AUL_Blend.h"
+#include "./AUL_Distance.h"
+#include "./AUL_Morphology.h"
+#include "./AUL_NativeArray.h"
+#include "./AUL_Noise.h"
+#include "./AUL_Random.h"
+#include "./AUL_Sampling.h"
+#include "./AUL_Type.h"
+#include "./AUL_Warp.h"
+
+static_assert(sizeof(aut_pixel) == sizeof(aut::PixelRGBA), "aut_pixel must match PixelRGBA");
+
+namespace aut {
+    namespace detail {
+        inline PixelRGBA* FromFfi(aut_pixel *p) {
+            return reinterpret_cast<PixelRGBA*>(p);
+        }
+        inline const PixelRGBA* FromFfi(const aut_pixel *p) {
+            return reinterpret_cast<const PixelRGBA*>(p);
+        }
+    }
+}
+
+AUT_FFI_EXPORT int aut_ffi_version(void) {
+    return 1;
+}
+
+AUT_FFI_EXPORT uint32_t aut_random_bits(int seed, int frame, uint32_t index) {
+    return aut::RandomBits(seed, frame, index);
+}
+
+AUT_FFI_EXPORT float aut_random_float(float st, float ed, int seed, int frame, uint32_t index) {
+    return aut::RandomFloat(st, ed, seed, frame, index);
+}
+
+AUT_FFI_EXPORT void aut_fill_random_bits(uint32_t *out, size_t count, int seed, int frame,
+                                         uint32_t first_index) {
+    aut::FillRandomBits(reinterpret_cast<aut::uint*>(out), count, seed, frame, first_index);
+}
+
+AUT_FFI_EXPORT void aut_fill_random_float(float *out, size_t count, float st, float ed, int seed, int frame,
+                                          uint32_t first_index) {
+    aut::FillRandomFloat(out, count, st, ed, seed, frame, first_index);
+}
+
+AUT_FFI_EXPORT float aut_fractal_noise2(float x, float y, int seed, int octaves, float frequency,
+                                        float lacunarity, float gain) {
+    return aut::FractalNoise(x, y, aut::NoiseParam(seed, octaves, frequency, lacunarity, gain));
+}
+
+AUT_FFI_EXPORT float aut_fractal_noise3(float x, float y, float z, int seed, int octaves, float frequency,
+                                        float lacunarity, float gain) {
+    return aut::FractalNoise(x, y, z, aut::NoiseParam(seed, octaves, frequency, lacunarity, gain));
+}
+
+AUT_FFI_EXPORT void aut_fill_noise2(float *out, uint32_t w, uint32_t h, double offset_x, double offset_y,
+                                    int seed, int octaves, float frequency, float lacunarity, float gain) {
+    aut::FillNoise(out, aut::Size2D(w, h), aut::NoiseParam(seed, octaves, frequency, lacunarity, gain),
+                   glm::dvec2(offset_x, offset_y));
+}
+
+AUT_FFI_EXPORT void aut_fill_noise3(float *out, uint32_t w, uint32_t h, float z, double offset_x,
+                                    double offset_y, int seed, int octaves, float frequency, float lacunarity,
+                                    float gain) {
+    aut::FillNoise(out, aut::Size2D(w, h), aut::NoiseParam(seed, octaves, frequency, lacunarity, gain), z,
+                   glm::dvec2(offset_x, offset_y));
+}
+
+AUT_FFI_EXPORT double aut_catmull_rom(double t, double p0, double p1, double p2, double p3) {
+    // 一様Catmull-Romスプライン (t = 0でp1、t = 1でp2)
+    double t2 = t * t, t3 = t2 * t;
+    return 0.5 * (2 * p1 + (p2 - p0) * t + (2 * p0 - 5 * p1 + 4 * p2 - p3) * t2 +
+                  (3 * p1 - p0 - 3 * p2 + p3) * t3);
+}
+
+AUT_FFI_EXPORT aut_pixel aut_sample(const aut_pixel *src, uint32_t w, uint32_t h, float x, float y,
+                                    int address, int filter) {
+    aut::PixelRGBA p = aut::Sample(aut::detail::FromFfi(src), aut::Size2D(w, h), x, y,
+                                   static_cast<aut::SamplingAddressMode>(address),
+                                   static_cast<aut::SamplingFilterMode>(filter));
+    aut_pixel ret = { p.b, p.g, p.r, p.a };
+    return ret;
+}
+
+AUT_FFI_EXPORT void aut_warp(aut_pixel *dst, uint32_t dst_w, uint32_t dst_h, const aut_pixel *src,
+                             uint32_t src_w, uint32_t src_h, const double *matrix, int address, int filter) {
+    glm::dmat3 m(matrix[0], matrix[1], matrix[2], matrix[3], matrix[4], matrix[5],
+                 matrix[6], matrix[7], matrix[8]);
+    aut::Warp(aut::detail::FromFfi(dst), aut::Size2D(dst_w, dst_h), aut::detail::FromFfi(src),
+              aut::Size2D(src_w, src_h), m, static_cast<aut::SamplingAddressMode>(address),
+              static_cast<aut::SamplingFilterMode>(filter));
+}
+
+AUT_FFI_EXPORT void aut_composite(aut_pixel *dst, size_t dst_stride, const aut_pixel *src, size_t src_stride,
+                                  uint32_t w, uint32_t h, int mode, float opacity, const uint8_t *mask,
+                                  int premultiplied) {
+    aut::Composite(aut::detail::FromFfi(dst), dst_stride, aut::detail::FromFfi(src), src_stride,
+                   aut::Size2D(w, h), static_cast<aut::BlendMode>(mode), opacity, mask, premultiplied != 0);
+}
+
+AUT_FFI_EXPORT void aut_morphology(aut_pixel *data, uint32_t w, uint32_t h, int op, int radius, int shape) {
+    aut::Morphology(aut::detail::FromFfi(data), aut::Size2D(w, h), static_cast<aut::MorphologyOp>(op), radius,
+                    static_cast<aut::MorphologyShape>(shape));
+}
+
+AUT_FFI_EXPORT void aut_signed_distance(float *dst, const aut_pixel *src, uint32_t w, uint32_t h,
+                                        uint8_t threshold) {
+    aut::SignedDistanceTransform(dst, aut::detail::FromFfi(src), aut::Size2D(w, h), threshold);
+}
+
+AUT_FFI_EXPORT int aut_native_array_view(void *array, void **data, size_t *length, size_t *stride, int *type) {
+    // LuaJITはuserdataをvoid*の引数に渡すと中身の先頭アドレスを渡す
+    if (!array)return 0;
+    const aut::NativeArray *a = static_cast<const aut::NativeArray*>(array);
+    if (data)*data = a->Data();
+    if (length)*length = a->Length();
+    if (stride)*stride = a->Stride();
+    if (type)*type = a->Type();
+    return 1;
+}
+
+#endif // AUT_FFI_IMPLEMENTATION
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_FFI_H_
@@ -0,0 +1,129 @@
+/**
+ * @file AUL_Hash.h
+ * @author SEED264
+ * @brief Fast non-cryptographic hashes for change detection
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_HASH_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_HASH_H_
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Hash a byte sequence
+     * Not cryptographic, only meant to detect changes of buffer contents.
+     *
+     * @param[in] data Data to hash
+     * @param[in] size Size of data in bytes
+     * @param[in] seed Initial value (pass the previous result to chain)
+     *
+     * @return unsigned long long Hash value
+     */
+    unsigned long long HashBytes(const void *data, size_t size, unsigned long long seed = 0);
+    /**
+     * Hash a rectangle of a pixel buffer
+     * The rectangle must be inside the buffer.
+     *
+     * @param[in] data Pixel data
+     * @param[in] stride Number of pixels per row of data
+     * @param[in] rect Rectangle to hash
+     *
+     * @return unsigned long long Hash value
+     */
+    unsigned long long HashPixels(const PixelRGBA *data, size_t stride, Rect2D rect);
+    /**
+     * Hash the bytes of several values (e.g. the parameters a job depends on)
+     * Values must be trivially copyable and should not contain padding.
+     *
+     * @param[in] values Values to hash
+     *
+     * @return unsigned long long Hash value
+     */
+    template<typename... Values>
+    unsigned long long HashValues(const Values&... values);
+
+    namespace detail {
+        constexpr unsigned long long kHashMul = 0x9E3779B97F4A7C15ull;
+
+        inline unsigned long long HashMix(unsigned long long h, unsigned long long v) {
+            h = (h ^ v) * kHashMul;
+            return h ^ (h >> 29);
+        }
+    }
+}
+
+inline unsigned long long aut::HashBytes(const void *data, size_t size, unsigned long long seed) {
+    const byte *p = static_cast<const byte*>(data);
+    // 依存関係を切るために4系統で並行して混ぜる
+    unsigned long long h[4] = { seed ^ size, seed + detail::kHashMul, ~seed, seed ^ 0xC3A5C85C97CB3127ull };
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int j = 0; j < 4; j++) {
+            unsigned long long v;
+            std::memcpy(&v, p + i + j * 8, 8);
+            h[j] = detail::HashMix(h[j], v);
+        }
+    }
+    for (; i + 8 <= size; i += 8) {
+        unsigned long long v;
+        std::memcpy(&v, p + i, 8);
+        h[0] = detail::HashMix(h[0], v);
+    }
+    if (i < size) {
+        unsigned long long v = 0;
+        std::memcpy(&v, p + i, size - i);
+        h[1] = detail::HashMix(h[1], v);
+    }
+    unsigned long long r = detail::HashMix(h[0], h[1]);
+    r = detail::HashMix(r, h[2]);
+    return detail::HashMix(r, h[3]);
+}
+
+inline unsigned long long aut::HashPixels(const PixelRGBA *data, size_t stride, Rect2D rect) {
+    unsigned long long h = 0;
+    for (unsigned int y = 0; y < rect.h; y++) {
+        const PixelRGBA *row = data + (rect.y + y) * stride + rect.x;
+        h = HashBytes(row, rect.w * sizeof(PixelRGBA), h);
+    }
+    return h;
+}
+
+template<typename... Values>
+inline unsigned long long aut::HashValues(const Values&... values) {
+    static_assert((std::is_trivially_copyable<Values>::value && ...), "values must be trivially copyable");
+    unsigned long long h = 0;
+    ((h = HashBytes(&values, sizeof(Values), h)), ...);
+    return h;
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_HASH_H_
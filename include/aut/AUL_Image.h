@@ -0,0 +1,381 @@
+/**
+ * @file AUL_Image.h
+ * @author SEED264
+ * @brief Images with compile-time pixel formats
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_IMAGE_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_IMAGE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include "./AUL_Memory.h"
+#include "./AUL_Parallel.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Format policies
+     *
+     * Every format stores channels in the same order as PixelRGBA (BGRA), so
+     * conversions are channel-wise and need no shuffles. Each policy provides
+     *   Pixel                 Element type
+     *   Load(pixel)           Pixel -> normalized PixelRGBA32F (1.0 = full)
+     *   Store(color)          Normalized PixelRGBA32F -> Pixel
+     *   FromHost(src, dst, n) PixelRGBA[n] -> Pixel[n]
+     *   ToHost(src, dst, n)   Pixel[n] -> PixelRGBA[n]
+     */
+    // 8bit (PixelRGBAそのもの)
+    struct FormatBGRA8 {
+        using Pixel = PixelRGBA;
+        static PixelRGBA32F Load(const Pixel &p);
+        static Pixel Store(const PixelRGBA32F &c);
+        static void FromHost(const PixelRGBA *src, Pixel *dst, size_t n);
+        static void ToHost(const Pixel *src, PixelRGBA *dst, size_t n);
+    };
+    // 16bit整数
+    struct FormatRGBA16 {
+        using Pixel = PixelRGBA16;
+        static PixelRGBA32F Load(const Pixel &p);
+        static Pixel Store(const PixelRGBA32F &c);
+        static void FromHost(const PixelRGBA *src, Pixel *dst, size_t n);
+        static void ToHost(const Pixel *src, PixelRGBA *dst, size_t n);
+    };
+    // 32bit浮動小数点数
+    struct FormatRGBA32F {
+        using Pixel = PixelRGBA32F;
+        static PixelRGBA32F Load(const Pixel &p);
+        static Pixel Store(const PixelRGBA32F &c);
+        static void FromHost(const PixelRGBA *src, Pixel *dst, size_t n);
+        static void ToHost(const Pixel *src, PixelRGBA *dst, size_t n);
+    };
+    // 16bit浮動小数点数
+    struct FormatRGBA16F {
+        using Pixel = PixelRGBA16F;
+        static PixelRGBA32F Load(const Pixel &p);
+        static Pixel Store(const PixelRGBA32F &c);
+        static void FromHost(const PixelRGBA *src, Pixel *dst, size_t n);
+        static void ToHost(const Pixel *src, PixelRGBA *dst, size_t n);
+    };
+
+    /**
+     * Image whose pixel format is fixed at compile time
+     * Rows start at 64-byte aligned addresses.
+     */
+    template<typename Format>
+    class Image {
+    public:
+        using Pixel = typename Format::Pixel;
+
+        Image();
+        explicit Image(Size2D size);
+        Image(Image &&other);
+        Image& operator=(Image &&other);
+        Image(const Image&) = delete;
+        Image& operator=(const Image&) = delete;
+        ~Image();
+
+        /**
+         * Change the size (the content becomes undefined)
+         * Memory is reused if the current allocation is large enough.
+         */
+        void Resize(Size2D size);
+        Pixel* Data();
+        const Pixel* Data() const;
+        Pixel* Row(unsigned int y);
+        const Pixel* Row(unsigned int y) const;
+        Pixel& At(unsigned int x, unsigned int y);
+        const Pixel& At(unsigned int x, unsigned int y) const;
+        Size2D GetSize() const;
+        /**
+         * Number of pixels from the start of a row to the next one
+         */
+        size_t Stride() const;
+
+        /**
+         * Resize to size and convert the host pixel data
+         *
+         * @param[in] src Pixel data (e.g. of obj.getpixeldata)
+         * @param[in] size Image size
+         */
+        void FromHost(const PixelRGBA *src, Size2D size);
+        /**
+         * Convert to the host pixel data
+         *
+         * @param[out] dst Destination (GetSize().w * GetSize().h, packed)
+         */
+        void ToHost(PixelRGBA *dst) const;
+
+    private:
+        Pixel *data_;
+        Size2D size_;
+        size_t stride_;
+        size_t capacity_;
+    };
+
+    using Image8 = Image<FormatBGRA8>;
+    using Image16 = Image<FormatRGBA16>;
+    using Image32F = Image<FormatRGBA32F>;
+    using Image16F = Image<FormatRGBA16F>;
+
+    /**
+     * Apply func to every pixel as normalized float color
+     * func is called as func(PixelRGBA32F &color, unsigned int x, unsigned int y).
+     * The loop is specialized for the format, rows are processed in parallel.
+     */
+    template<typename Format, typename Func>
+    void TransformPixels(Image<Format> &image, Func func);
+
+    namespace detail {
+        // チャンネル単位で8個ずつ変換するループ (端数はスカラーで処理)
+        template<typename SrcT, typename DstT, typename LoadV, typename StoreV>
+        void ConvertChannels(const SrcT *src, DstT *dst, size_t n, LoadV load, StoreV store);
+    }
+}
+
+template<typename SrcT, typename DstT, typename LoadV, typename StoreV>
+inline void aut::detail::ConvertChannels(const SrcT *src, DstT *dst, size_t n,
+                                         LoadV load, StoreV store) {
+    size_t i = 0;
+    for (; i + simd::kLanes <= n; i += simd::kLanes) {
+        store(dst + i, load(src + i));
+    }
+    if (i < n) {
+        SrcT s[simd::kLanes] = {};
+        DstT d[simd::kLanes];
+        std::copy(src + i, src + n, s);
+        store(d, load(s));
+        std::copy(d, d + (n - i), dst + i);
+    }
+}
+
+inline aut::PixelRGBA32F aut::FormatBGRA8::Load(const Pixel &p) {
+    const float s = 1.f / 255;
+    return PixelRGBA32F(p.r * s, p.g * s, p.b * s, p.a * s);
+}
+
+inline aut::PixelRGBA aut::FormatBGRA8::Store(const PixelRGBA32F &c) {
+    auto q = [](float v) { return static_cast<byte>(std::min(std::max(v * 255 + 0.5f, 0.f), 255.f)); };
+    return PixelRGBA(q(c.r), q(c.g), q(c.b), q(c.a));
+}
+
+inline void aut::FormatBGRA8::FromHost(const PixelRGBA *src, Pixel *dst, size_t n) {
+    std::memcpy(dst, src, n * sizeof(Pixel));
+}
+
+inline void aut::FormatBGRA8::ToHost(const Pixel *src, PixelRGBA *dst, size_t n) {
+    std::memcpy(dst, src, n * sizeof(Pixel));
+}
+
+inline aut::PixelRGBA32F aut::FormatRGBA16::Load(const Pixel &p) {
+    const float s = 1.f / 65535;
+    return PixelRGBA32F(p.r * s, p.g * s, p.b * s, p.a * s);
+}
+
+inline aut::PixelRGBA16 aut::FormatRGBA16::Store(const PixelRGBA32F &c) {
+    auto q = [](float v) {
+        return static_cast<unsigned short>(std::min(std::max(v * 65535 + 0.5f, 0.f), 65535.f));
+    };
+    return PixelRGBA16(q(c.r), q(c.g), q(c.b), q(c.a));
+}
+
+inline void aut::FormatRGBA16::FromHost(const PixelRGBA *src, Pixel *dst, size_t n) {
+    detail::ConvertChannels(reinterpret_cast<const byte*>(src), reinterpret_cast<unsigned short*>(dst), n * 4,
+        [](const byte *s) { return simd::LoadU8(s) * simd::Set1(257.f); },
+        [](unsigned short *d, simd::VFloat v) { simd::StoreU16(d, v); });
+}
+
+inline void aut::FormatRGBA16::ToHost(const Pixel *src, PixelRGBA *dst, size_t n) {
+    detail::ConvertChannels(reinterpret_cast<const unsigned short*>(src), reinterpret_cast<byte*>(dst), n * 4,
+        [](const unsigned short *s) { return simd::LoadU16(s) * simd::Set1(1.f / 257); },
+        [](byte *d, simd::VFloat v) { simd::StoreU8(d, v); });
+}
+
+inline aut::PixelRGBA32F aut::FormatRGBA32F::Load(const Pixel &p) {
+    return p;
+}
+
+inline aut::PixelRGBA32F aut::FormatRGBA32F::Store(const PixelRGBA32F &c) {
+    return c;
+}
+
+inline void aut::FormatRGBA32F::FromHost(const PixelRGBA *src, Pixel *dst, size_t n) {
+    detail::ConvertChannels(reinterpret_cast<const byte*>(src), reinterpret_cast<float*>(dst), n * 4,
+        [](const byte *s) { return simd::LoadU8(s) * simd::Set1(1.f / 255); },
+        [](float *d, simd::VFloat v) { simd::Store(d, v); });
+}
+
+inline void aut::FormatRGBA32F::ToHost(const Pixel *src, PixelRGBA *dst, size_t n) {
+    detail::ConvertChannels(reinterpret_cast<const float*>(src), reinterpret_cast<byte*>(dst), n * 4,
+        [](const float *s) { return simd::Load(s) * simd::Set1(255.f); },
+        [](byte *d, simd::VFloat v) { simd::StoreU8(d, v); });
+}
+
+inline aut::PixelRGBA32F aut::FormatRGBA16F::Load(const Pixel &p) {
+    using simd::HalfToFloat;
+    return PixelRGBA32F(HalfToFloat(p.r), HalfToFloat(p.g), HalfToFloat(p.b), HalfToFloat(p.a));
+}
+
+inline aut::PixelRGBA16F aut::FormatRGBA16F::Store(const PixelRGBA32F &c) {
+    using simd::FloatToHalf;
+    return PixelRGBA16F(FloatToHalf(c.r), FloatToHalf(c.g), FloatToHalf(c.b), FloatToHalf(c.a));
+}
+
+inline void aut::FormatRGBA16F::FromHost(const PixelRGBA *src, Pixel *dst, size_t n) {
+    detail::ConvertChannels(reinterpret_cast<const byte*>(src), reinterpret_cast<unsigned short*>(dst), n * 4,
+        [](const byte *s) { return simd::LoadU8(s) * simd::Set1(1.f / 255); },
+        [](unsigned short *d, simd::VFloat v) { simd::StoreHalf(d, v); });
+}
+
+inline void aut::FormatRGBA16F::ToHost(const Pixel *src, PixelRGBA *dst, size_t n) {
+    detail::ConvertChannels(reinterpret_cast<const unsigned short*>(src), reinterpret_cast<byte*>(dst), n * 4,
+        [](const unsigned short *s) { return simd::LoadHalf(s) * simd::Set1(255.f); },
+        [](byte *d, simd::VFloat v) { simd::StoreU8(d, v); });
+}
+
+template<typename Format>
+inline aut::Image<Format>::Image() : data_(nullptr), size_(), stride_(0), capacity_(0) {}
+
+template<typename Format>
+inline aut::Image<Format>::Image(Size2D size) : Image() {
+    Resize(size);
+}
+
+template<typename Format>
+inline aut::Image<Format>::Image(Image &&other)
+    : data_(other.data_), size_(other.size_), stride_(other.stride_), capacity_(other.capacity_) {
+    other.data_ = nullptr;
+    other.size_ = Size2D();
+    other.capacity_ = 0;
+}
+
+template<typename Format>
+inline aut::Image<Format>& aut::Image<Format>::operator=(Image &&other) {
+    if (this != &other) {
+        AlignedFree(data_);
+        data_ = other.data_;
+        size_ = other.size_;
+        stride_ = other.stride_;
+        capacity_ = other.capacity_;
+        other.data_ = nullptr;
+        other.size_ = Size2D();
+        other.capacity_ = 0;
+    }
+    return *this;
+}
+
+template<typename Format>
+inline aut::Image<Format>::~Image() {
+    AlignedFree(data_);
+}
+
+template<typename Format>
+inline void aut::Image<Format>::Resize(Size2D size) {
+    size_t stride = ImageStride(size.w, sizeof(Pixel));
+    size_t required = stride * size.h;
+    if (required > capacity_) {
+        AlignedFree(data_);
+        data_ = static_cast<Pixel*>(AlignedAlloc(required * sizeof(Pixel)));
+        capacity_ = data_ != nullptr ? required : 0;
+    }
+    size_ = data_ != nullptr ? size : Size2D();
+    stride_ = stride;
+}
+
+template<typename Format>
+inline typename aut::Image<Format>::Pixel* aut::Image<Format>::Data() {
+    return data_;
+}
+
+template<typename Format>
+inline const typename aut::Image<Format>::Pixel* aut::Image<Format>::Data() const {
+    return data_;
+}
+
+template<typename Format>
+inline typename aut::Image<Format>::Pixel* aut::Image<Format>::Row(unsigned int y) {
+    return data_ + y * stride_;
+}
+
+template<typename Format>
+inline const typename aut::Image<Format>::Pixel* aut::Image<Format>::Row(unsigned int y) const {
+    return data_ + y * stride_;
+}
+
+template<typename Format>
+inline typename aut::Image<Format>::Pixel& aut::Image<Format>::At(unsigned int x, unsigned int y) {
+    return data_[y * stride_ + x];
+}
+
+template<typename Format>
+inline const typename aut::Image<Format>::Pixel& aut::Image<Format>::At(unsigned int x, unsigned int y) const {
+    return data_[y * stride_ + x];
+}
+
+template<typename Format>
+inline aut::Size2D aut::Image<Format>::GetSize() const {
+    return size_;
+}
+
+template<typename Format>
+inline size_t aut::Image<Format>::Stride() const {
+    return stride_;
+}
+
+template<typename Format>
+inline void aut::Image<Format>::FromHost(const PixelRGBA *src, Size2D size) {
+    Resize(size);
+    ParallelFor(0, size_.h, [&](size_t y) {
+        Format::FromHost(src + y * size_.w, data_ + y * stride_, size_.w);
+    }, 16);
+}
+
+template<typename Format>
+inline void aut::Image<Format>::ToHost(PixelRGBA *dst) const {
+    ParallelFor(0, size_.h, [&](size_t y) {
+        Format::ToHost(data_ + y * stride_, dst + y * size_.w, size_.w);
+    }, 16);
+}
+
+template<typename Format, typename Func>
+inline void aut::TransformPixels(Image<Format> &image, Func func) {
+    Size2D size = image.GetSize();
+    ParallelFor(0, size.h, [&](size_t y) {
+        typename Format::Pixel *row = image.Row(static_cast<unsigned int>(y));
+        for (unsigned int x = 0; x < size.w; x++) {
+            PixelRGBA32F c = Format::Load(row[x]);
+            func(c, x, static_cast<unsigned int>(y));
+            row[x] = Format::Store(c);
+        }
+    }, 16);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_IMAGE_H_
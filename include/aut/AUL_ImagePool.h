@@ -0,0 +1,379 @@
+/**
+ * @file AUL_ImagePool.h
+ * @author SEED264
+ * @brief Pool of aligned scratch images
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_IMAGEPOOL_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_IMAGEPOOL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <lua.hpp>
+#include "./AUL_Memory.h"
+#include "./AUL_Type.h"
+#include "./AUL_Wrapper.h"
+
+namespace aut {
+    class ImagePool;
+
+    /**
+     * Scratch image borrowed from ImagePool
+     * Rows start at 64-byte aligned addresses, and the image is returned to
+     * the pool when the handle is destroyed.
+     */
+    class ScratchImage {
+    public:
+        ScratchImage();
+        ScratchImage(ScratchImage &&other);
+        ScratchImage& operator=(ScratchImage &&other);
+        ScratchImage(const ScratchImage&) = delete;
+        ScratchImage& operator=(const ScratchImage&) = delete;
+        ~ScratchImage();
+
+        /**
+         * Whether the image is available (false if the budget was exceeded)
+         */
+        bool IsValid() const;
+        PixelRGBA* Data() const;
+        PixelRGBA* Row(unsigned int y) const;
+        Size2D GetSize() const;
+        /**
+         * Number of pixels from the start of a row to the next one
+         */
+        size_t Stride() const;
+        /**
+         * Return the image to the pool before destruction
+         */
+        void Release();
+
+    private:
+        friend class ImagePool;
+
+        ImagePool *pool_;
+        PixelRGBA *data_;
+        size_t block_bytes_;
+        Size2D size_;
+        size_t stride_;
+    };
+
+    // ImagePoolの統計情報用の構造体
+    struct ImagePoolStats {
+        size_t request_num;
+        size_t hit_num;
+        size_t reject_num;
+        size_t bytes_in_use;
+        size_t bytes_cached;
+        size_t peak_bytes;
+
+        ImagePoolStats()
+            : request_num(0), hit_num(0), reject_num(0),
+              bytes_in_use(0), bytes_cached(0), peak_bytes(0) {}
+
+        double HitRate() const {
+            return request_num ? static_cast<double>(hit_num) / request_num : 0;
+        }
+    };
+
+    /**
+     * Pool of scratch images bucketed by size
+     *
+     * Returned images are kept and handed out again for requests of the same
+     * size class, so effects do not allocate per frame. The total of images
+     * in use and cached never exceeds the byte budget.
+     */
+    class ImagePool {
+    public:
+        /**
+         * @param[in] budget_bytes Maximum bytes held by the pool
+         */
+        explicit ImagePool(size_t budget_bytes = 512 * 1024 * 1024);
+        ImagePool(const ImagePool&) = delete;
+        ImagePool& operator=(const ImagePool&) = delete;
+        ~ImagePool();
+
+        /**
+         * Borrow a scratch image
+         * The content is undefined.
+         *
+         * @param[in] size Image size
+         *
+         * @return ScratchImage Image (invalid if the budget would be exceeded)
+         */
+        ScratchImage Get(Size2D size);
+        /**
+         * Borrow a scratch image
+         * On first use, the pool is pre-warmed with images of obj.getinfo("image_max").
+         *
+         * @param[in] size Image size
+         *
+         * @return ScratchImage Image (invalid if the budget would be exceeded)
+         */
+        ScratchImage Get(lua_State *L, Size2D size);
+        /**
+         * Allocate images in advance
+         *
+         * @param[in] size Image size
+         * @param[in] count Number of images
+         */
+        void Prewarm(Size2D size, size_t count);
+        /**
+         * Allocate images of obj.getinfo("image_max") in advance
+         *
+         * @param[in] count Number of images
+         */
+        void Prewarm(lua_State *L, size_t count = 2);
+        /**
+         * Change the byte budget
+         * Cached images are freed until the pool fits in the new budget.
+         */
+        void SetBudget(size_t budget_bytes);
+        /**
+         * Free all cached images (images in use are not affected)
+         */
+        void Trim();
+        ImagePoolStats GetStats() const;
+
+        /**
+         * Get the pool shared by the whole DLL
+         */
+        static ImagePool& Default();
+
+        /**
+         * Number of pixels per row for an image width (ImageStride for PixelRGBA)
+         */
+        static size_t StrideFor(unsigned int width);
+
+    private:
+        friend class ScratchImage;
+
+        static size_t SizeClass(size_t bytes);
+        ScratchImage Acquire(Size2D size, bool count_request);
+        void Release(PixelRGBA *data, size_t block_bytes);
+        bool EvictFor(size_t bytes);
+
+        mutable std::mutex mutex_;
+        size_t budget_bytes_;
+        bool prewarmed_;
+        std::map<size_t, std::vector<PixelRGBA*>> free_blocks_;
+        ImagePoolStats stats_;
+    };
+}
+
+inline aut::ScratchImage::ScratchImage()
+    : pool_(nullptr), data_(nullptr), block_bytes_(0), size_(), stride_(0) {}
+
+inline aut::ScratchImage::ScratchImage(ScratchImage &&other)
+    : pool_(other.pool_), data_(other.data_), block_bytes_(other.block_bytes_),
+      size_(other.size_), stride_(other.stride_) {
+    other.pool_ = nullptr;
+    other.data_ = nullptr;
+}
+
+inline aut::ScratchImage& aut::ScratchImage::operator=(ScratchImage &&other) {
+    if (this != &other) {
+        Release();
+        pool_ = other.pool_;
+        data_ = other.data_;
+        block_bytes_ = other.block_bytes_;
+        size_ = other.size_;
+        stride_ = other.stride_;
+        other.pool_ = nullptr;
+        other.data_ = nullptr;
+    }
+    return *this;
+}
+
+inline aut::ScratchImage::~ScratchImage() {
+    Release();
+}
+
+inline bool aut::ScratchImage::IsValid() const {
+    return data_ != nullptr;
+}
+
+inline aut::PixelRGBA* aut::ScratchImage::Data() const {
+    return data_;
+}
+
+inline aut::PixelRGBA* aut::ScratchImage::Row(unsigned int y) const {
+    return data_ + y * stride_;
+}
+
+inline aut::Size2D aut::ScratchImage::GetSize() const {
+    return size_;
+}
+
+inline size_t aut::ScratchImage::Stride() const {
+    return stride_;
+}
+
+inline void aut::ScratchImage::Release() {
+    if (pool_ != nullptr && data_ != nullptr)
+        pool_->Release(data_, block_bytes_);
+    pool_ = nullptr;
+    data_ = nullptr;
+}
+
+inline aut::ImagePool::ImagePool(size_t budget_bytes)
+    : budget_bytes_(budget_bytes), prewarmed_(false) {}
+
+inline aut::ImagePool::~ImagePool() {
+    Trim();
+}
+
+inline aut::ScratchImage aut::ImagePool::Get(Size2D size) {
+    return Acquire(size, true);
+}
+
+inline aut::ScratchImage aut::ImagePool::Acquire(Size2D size, bool count_request) {
+    ScratchImage image;
+    size_t stride = StrideFor(size.w);
+    size_t block_bytes = SizeClass(stride * std::max(size.h, 1u) * sizeof(PixelRGBA));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_request)stats_.request_num++;
+    auto it = free_blocks_.find(block_bytes);
+    if (it != free_blocks_.end() && !it->second.empty()) {
+        image.data_ = it->second.back();
+        it->second.pop_back();
+        if (count_request)stats_.hit_num++;
+        stats_.bytes_cached -= block_bytes;
+    } else {
+        if (!EvictFor(block_bytes)) {
+            if (count_request)stats_.reject_num++;
+            return image;
+        }
+        image.data_ = static_cast<PixelRGBA*>(AlignedAlloc(block_bytes));
+        if (image.data_ == nullptr) {
+            if (count_request)stats_.reject_num++;
+            return image;
+        }
+    }
+    stats_.bytes_in_use += block_bytes;
+    stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.bytes_in_use + stats_.bytes_cached);
+    image.pool_ = this;
+    image.block_bytes_ = block_bytes;
+    image.size_ = size;
+    image.stride_ = stride;
+    return image;
+}
+
+inline aut::ScratchImage aut::ImagePool::Get(lua_State *L, Size2D size) {
+    bool need_prewarm;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        need_prewarm = !prewarmed_;
+    }
+    if (need_prewarm)
+        Prewarm(L);
+    return Get(size);
+}
+
+inline void aut::ImagePool::Prewarm(Size2D size, size_t count) {
+    // 事前確保分はヒット率の統計に数えず、バイト数だけを残す
+    {
+        std::vector<ScratchImage> images;
+        for (size_t i = 0; i < count; i++) {
+            images.push_back(Acquire(size, false));
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    prewarmed_ = true;
+}
+
+inline void aut::ImagePool::Prewarm(lua_State *L, size_t count) {
+    Prewarm(getinfo_image_max(L), count);
+}
+
+inline void aut::ImagePool::SetBudget(size_t budget_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_bytes_ = budget_bytes;
+    EvictFor(0);
+}
+
+inline void aut::ImagePool::Trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &bucket : free_blocks_) {
+        for (PixelRGBA *block : bucket.second) AlignedFree(block);
+        stats_.bytes_cached -= bucket.first * bucket.second.size();
+    }
+    free_blocks_.clear();
+}
+
+inline aut::ImagePoolStats aut::ImagePool::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+inline aut::ImagePool& aut::ImagePool::Default() {
+    static ImagePool pool;
+    return pool;
+}
+
+inline size_t aut::ImagePool::StrideFor(unsigned int width) {
+    return ImageStride(width, sizeof(PixelRGBA));
+}
+
+inline size_t aut::ImagePool::SizeClass(size_t bytes) {
+    // 2のべき乗の間を4分割したサイズに切り上げる (無駄は最大25%)
+    size_t power = kCacheLineSize;
+    while (power * 2 <= bytes) power *= 2;
+    size_t step = std::max<size_t>(power / 4, kCacheLineSize);
+    return (bytes + step - 1) / step * step;
+}
+
+inline void aut::ImagePool::Release(PixelRGBA *data, size_t block_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytes_in_use -= block_bytes;
+    if (stats_.bytes_in_use + stats_.bytes_cached + block_bytes > budget_bytes_) {
+        AlignedFree(data);
+        return;
+    }
+    free_blocks_[block_bytes].push_back(data);
+    stats_.bytes_cached += block_bytes;
+}
+
+inline bool aut::ImagePool::EvictFor(size_t bytes) {
+    // 大きいバケットから解放していく
+    for (auto it = free_blocks_.rbegin(); it != free_blocks_.rend(); ++it) {
+        while (stats_.bytes_in_use + stats_.bytes_cached + bytes > budget_bytes_ && !it->second.empty()) {
+            AlignedFree(it->second.back());
+            it->second.pop_back();
+            stats_.bytes_cached -= it->first;
+        }
+    }
+    return stats_.bytes_in_use + stats_.bytes_cached + bytes <= budget_bytes_;
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_IMAGEPOOL_H_
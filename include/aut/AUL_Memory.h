@@ -0,0 +1,98 @@
+/**
+ * @file AUL_Memory.h
+ * @author SEED264
+ * @brief Aligned memory helpers
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_MEMORY_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_MEMORY_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace aut {
+    // キャッシュライン及びAVXのロード幅に合わせたアライメント
+    constexpr size_t kCacheLineSize = 64;
+
+    /**
+     * Allocate aligned memory
+     *
+     * @param[in] size Size in bytes
+     * @param[in] alignment Alignment in bytes (power of 2)
+     *
+     * @return void* Allocated memory (nullptr on failure), free with AlignedFree
+     */
+    void* AlignedAlloc(size_t size, size_t alignment = kCacheLineSize);
+    /**
+     * Free memory allocated by AlignedAlloc
+     */
+    void AlignedFree(void *ptr);
+    /**
+     * Number of pixels per row for an image width
+     * Rows are padded to 64 bytes, and strides of multiples of 4KiB are
+     * avoided to reduce cache set conflicts between rows.
+     *
+     * @param[in] width Image width in pixels
+     * @param[in] pixel_bytes Size of a pixel in bytes
+     *
+     * @return size_t Row stride in pixels
+     */
+    size_t ImageStride(size_t width, size_t pixel_bytes);
+}
+
+inline void* aut::AlignedAlloc(size_t size, size_t alignment) {
+    size = (size + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    return std::aligned_alloc(alignment, size);
+#endif
+}
+
+inline void aut::AlignedFree(void *ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+inline size_t aut::ImageStride(size_t width, size_t pixel_bytes) {
+    size_t row_bytes = (std::max<size_t>(width, 1) * pixel_bytes + kCacheLineSize - 1)
+                     / kCacheLineSize * kCacheLineSize;
+    if (row_bytes % 4096 == 0)
+        row_bytes += kCacheLineSize;
+    return (row_bytes + pixel_bytes - 1) / pixel_bytes;
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_MEMORY_H_
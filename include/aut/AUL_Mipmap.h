@@ -0,0 +1,418 @@
+/**
+ * @file AUL_Mipmap.h
+ * @author SEED264
+ * @brief Cached mipmap pyramids for minified sampling
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_MIPMAP_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_MIPMAP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "./AUL_Enum.h"
+#include "./AUL_Hash.h"
+#include "./AUL_Parallel.h"
+#include "./AUL_Sampling.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Image pyramid of a pixel buffer
+     *
+     * Level 0 is a copy of the source, and each following level halves the
+     * size down to 1x1. Update rebuilds the levels only when the size or the
+     * content hash of the source has changed.
+     */
+    class Mipmap {
+    public:
+        Mipmap();
+
+        /**
+         * Build the pyramid from src if it has changed since the last call
+         *
+         * @param[in] src Pixel data
+         * @param[in] size Image size
+         * @param[in] downsample Filter used to make each level
+         *
+         * @return bool true if the levels were rebuilt
+         */
+        bool Update(const PixelRGBA *src, Size2D size, MipmapDownsample downsample = kAutMipmapBox);
+        /**
+         * Release all levels
+         */
+        void Clear();
+        int LevelCount() const;
+        const PixelRGBA* Level(int level) const;
+        Size2D LevelSize(int level) const;
+        /**
+         * Total bytes held by the levels
+         */
+        size_t Bytes() const;
+        /**
+         * Sample the pyramid
+         * Coords are in level 0 pixels. With kAutFilterTrilinear the two
+         * levels around log2(footprint) are blended, otherwise level 0 is
+         * sampled as the plain Sample function does.
+         *
+         * @param[in] x,y Coords to sample
+         * @param[in] footprint Number of source pixels covered by one output pixel
+         * @param[in] address Addressing mode outside the image
+         * @param[in] filter Filter mode
+         *
+         * @return PixelRGBA Sampled pixel
+         */
+        PixelRGBA Sample(float x, float y, float footprint,
+                         SamplingAddressMode address = kAutAddressBorder,
+                         SamplingFilterMode filter = kAutFilterTrilinear) const;
+
+    private:
+        unsigned long long hash_;
+        MipmapDownsample downsample_;
+        std::vector<std::vector<PixelRGBA>> levels_;
+        std::vector<Size2D> sizes_;
+    };
+
+    /**
+     * Mipmaps cached per source buffer
+     * The least recently used pyramid is dropped when capacity is exceeded.
+     * A returned reference stays valid until the same key is requested again
+     * or the entry is evicted.
+     */
+    class MipmapCache {
+    public:
+        /**
+         * @param[in] capacity Maximum number of cached pyramids
+         */
+        explicit MipmapCache(size_t capacity = 8);
+        MipmapCache(const MipmapCache&) = delete;
+        MipmapCache& operator=(const MipmapCache&) = delete;
+
+        /**
+         * Get the pyramid of src, rebuilding it only if the contents changed
+         *
+         * @param[in] key Key identifying the source (e.g. the object index)
+         * @param[in] src Pixel data
+         * @param[in] size Image size
+         * @param[in] downsample Filter used to make each level
+         *
+         * @return const Mipmap& Up-to-date pyramid
+         */
+        const Mipmap& Get(const void *key, const PixelRGBA *src, Size2D size,
+                          MipmapDownsample downsample = kAutMipmapBox);
+        /**
+         * Get the pyramid of src using the buffer address as the key
+         */
+        const Mipmap& Get(const PixelRGBA *src, Size2D size,
+                          MipmapDownsample downsample = kAutMipmapBox);
+        void Clear();
+        /**
+         * Cache shared by the whole process
+         */
+        static MipmapCache& Default();
+
+    private:
+        struct Entry {
+            Mipmap mipmap;
+            unsigned long long last_use;
+        };
+
+        std::mutex mutex_;
+        size_t capacity_;
+        unsigned long long use_count_;
+        std::map<const void*, Entry> entries_;
+    };
+
+    namespace detail {
+        // 縮小時の1次元フィルターのタップ (出力1画素につきtaps個)
+        struct DownsampleTaps {
+            int taps;
+            std::vector<int> index;
+            std::vector<float> weight;
+        };
+
+        double BesselI0(double x);
+        DownsampleTaps MakeDownsampleTaps(unsigned int src_n, unsigned int dst_n,
+                                          MipmapDownsample downsample);
+        void Downsample(const PixelRGBA *src, Size2D src_size, PixelRGBA *dst, Size2D dst_size,
+                        MipmapDownsample downsample);
+        /**
+         * Sample a mipmap as premultiplied color (0 ~ 255)
+         */
+        template<SamplingAddressMode Address, SamplingFilterMode Filter>
+        PixelRGBA32F SampleMipmapPremultiplied(const Mipmap &mipmap, float x, float y, float footprint);
+    }
+}
+
+inline double aut::detail::BesselI0(double x) {
+    double sum = 1, term = 1, q = x * x / 4;
+    for (int k = 1; k < 32 && term > sum * 1e-12; k++) {
+        term *= q / (static_cast<double>(k) * k);
+        sum += term;
+    }
+    return sum;
+}
+
+inline aut::detail::DownsampleTaps aut::detail::MakeDownsampleTaps(unsigned int src_n, unsigned int dst_n,
+                                                                   MipmapDownsample downsample) {
+    const double kLobes = 2, kAlpha = 4;
+    const double kPi = 3.14159265358979323846;
+    double scale = static_cast<double>(src_n) / dst_n;
+    DownsampleTaps t;
+    if (downsample == kAutMipmapKaiser)
+        t.taps = static_cast<int>(std::ceil(2 * kLobes * scale)) + 1;
+    else
+        t.taps = static_cast<int>(std::ceil(scale)) + 1;
+    t.index.assign(static_cast<size_t>(dst_n) * t.taps, 0);
+    t.weight.assign(static_cast<size_t>(dst_n) * t.taps, 0.f);
+    double i0_alpha = BesselI0(kAlpha);
+    for (unsigned int i = 0; i < dst_n; i++) {
+        int *index = &t.index[static_cast<size_t>(i) * t.taps];
+        float *weight = &t.weight[static_cast<size_t>(i) * t.taps];
+        double sum = 0;
+        int first;
+        if (downsample == kAutMipmapKaiser) {
+            // 出力画素中心を中心とするKaiser窓付きsinc
+            double center = (i + 0.5) * scale - 0.5;
+            first = static_cast<int>(std::floor(center - kLobes * scale)) + 1;
+            for (int k = 0; k < t.taps; k++) {
+                double x = (first + k - center) / scale;
+                double w = 0;
+                if (std::abs(x) < kLobes) {
+                    double r = x / kLobes;
+                    w = BesselI0(kAlpha * std::sqrt(1 - r * r)) / i0_alpha;
+                    if (x != 0)w *= std::sin(kPi * x) / (kPi * x);
+                }
+                weight[k] = static_cast<float>(w);
+                sum += w;
+            }
+        } else {
+            // 出力画素が覆う範囲との重なりの長さ
+            double st = i * scale, ed = (i + 1) * scale;
+            first = static_cast<int>(std::floor(st));
+            for (int k = 0; k < t.taps; k++) {
+                double w = std::min(ed, first + k + 1.0) - std::max(st, static_cast<double>(first + k));
+                w = std::max(w, 0.0);
+                weight[k] = static_cast<float>(w);
+                sum += w;
+            }
+        }
+        for (int k = 0; k < t.taps; k++) {
+            index[k] = std::min(std::max(first + k, 0), static_cast<int>(src_n) - 1);
+            weight[k] = static_cast<float>(weight[k] / sum);
+        }
+    }
+    return t;
+}
+
+inline void aut::detail::Downsample(const PixelRGBA *src, Size2D src_size, PixelRGBA *dst, Size2D dst_size,
+                                    MipmapDownsample downsample) {
+    using namespace simd;
+    DownsampleTaps vt = MakeDownsampleTaps(src_size.h, dst_size.h, downsample);
+    DownsampleTaps ht = MakeDownsampleTaps(src_size.w, dst_size.w, downsample);
+    const unsigned int kBand = 8;
+    const unsigned int w = src_size.w;
+    const unsigned int simd_w = w / kLanes * kLanes;
+    ParallelFor(0, (dst_size.h + kBand - 1) / kBand, [&](size_t band) {
+        // 縦方向の畳み込み結果を乗算済みのプレーンで保持する
+        std::vector<float> planes(static_cast<size_t>(w) * 4);
+        float *pb = planes.data(), *pg = pb + w, *pr = pg + w, *pa = pr + w;
+        unsigned int y0 = static_cast<unsigned int>(band) * kBand;
+        unsigned int y1 = std::min(y0 + kBand, dst_size.h);
+        for (unsigned int y = y0; y < y1; y++) {
+            std::fill(planes.begin(), planes.end(), 0.f);
+            for (int k = 0; k < vt.taps; k++) {
+                float weight = vt.weight[static_cast<size_t>(y) * vt.taps + k];
+                if (weight == 0)continue;
+                const PixelRGBA *row = src + static_cast<size_t>(vt.index[static_cast<size_t>(y) * vt.taps + k]) * w;
+                VFloat vw = Set1(weight), aw = Set1(weight / 255);
+                for (unsigned int x = 0; x < simd_w; x += kLanes) {
+                    VFloat b, g, r, a;
+                    LoadPixels(row + x, &b, &g, &r, &a);
+                    VFloat m = a * aw;
+                    Store(pb + x, Load(pb + x) + b * m);
+                    Store(pg + x, Load(pg + x) + g * m);
+                    Store(pr + x, Load(pr + x) + r * m);
+                    Store(pa + x, Load(pa + x) + a * vw);
+                }
+                for (unsigned int x = simd_w; x < w; x++) {
+                    float m = row[x].a * (weight / 255);
+                    pb[x] += row[x].b * m;
+                    pg[x] += row[x].g * m;
+                    pr[x] += row[x].r * m;
+                    pa[x] += row[x].a * weight;
+                }
+            }
+            PixelRGBA *out = dst + static_cast<size_t>(y) * dst_size.w;
+            for (unsigned int x = 0; x < dst_size.w; x++) {
+                const int *index = &ht.index[static_cast<size_t>(x) * ht.taps];
+                const float *weight = &ht.weight[static_cast<size_t>(x) * ht.taps];
+                PixelRGBA32F c;
+                for (int k = 0; k < ht.taps; k++) {
+                    c.b += pb[index[k]] * weight[k];
+                    c.g += pg[index[k]] * weight[k];
+                    c.r += pr[index[k]] * weight[k];
+                    c.a += pa[index[k]] * weight[k];
+                }
+                out[x] = Unpremultiply(c);
+            }
+        }
+    });
+}
+
+template<aut::SamplingAddressMode Address, aut::SamplingFilterMode Filter>
+inline aut::PixelRGBA32F aut::detail::SampleMipmapPremultiplied(const Mipmap &mipmap, float x, float y,
+                                                                float footprint) {
+    int levels = mipmap.LevelCount();
+    if (levels == 0)return PixelRGBA32F();
+    Size2D base = mipmap.LevelSize(0);
+    if (Filter != kAutFilterTrilinear || levels == 1 || !(footprint > 1))
+        return SamplePremultiplied<Address, Filter == kAutFilterNearest ? kAutFilterNearest : kAutFilterLinear>(
+            mipmap.Level(0), base, x, y);
+    float lod = std::min(std::log2(footprint), static_cast<float>(levels - 1));
+    int l0 = static_cast<int>(lod);
+    int l1 = std::min(l0 + 1, levels - 1);
+    float t = lod - l0;
+    auto sample_level = [&](int l) {
+        Size2D s = mipmap.LevelSize(l);
+        float sx = static_cast<float>(s.w) / base.w, sy = static_cast<float>(s.h) / base.h;
+        return SamplePremultiplied<Address, kAutFilterLinear>(mipmap.Level(l), s, x * sx, y * sy);
+    };
+    PixelRGBA32F c0 = sample_level(l0);
+    if (t <= 0 || l0 == l1)return c0;
+    PixelRGBA32F c1 = sample_level(l1);
+    return PixelRGBA32F(c0.r + (c1.r - c0.r) * t, c0.g + (c1.g - c0.g) * t,
+                        c0.b + (c1.b - c0.b) * t, c0.a + (c1.a - c0.a) * t);
+}
+
+inline aut::Mipmap::Mipmap()
+    : hash_(0), downsample_(kAutMipmapBox) {}
+
+inline bool aut::Mipmap::Update(const PixelRGBA *src, Size2D size, MipmapDownsample downsample) {
+    if (!src || size.w == 0 || size.h == 0) {
+        Clear();
+        return false;
+    }
+    unsigned long long hash = HashPixels(src, size.w, Rect2D(0, 0, size.w, size.h));
+    if (!sizes_.empty() && sizes_[0].w == size.w && sizes_[0].h == size.h &&
+        hash == hash_ && downsample == downsample_)
+        return false;
+    hash_ = hash;
+    downsample_ = downsample;
+    sizes_.clear();
+    sizes_.push_back(size);
+    while (sizes_.back().w > 1 || sizes_.back().h > 1) {
+        Size2D s = sizes_.back();
+        sizes_.push_back(Size2D(std::max(s.w / 2, 1u), std::max(s.h / 2, 1u)));
+    }
+    // 既存のレベルの確保領域は使い回す
+    levels_.resize(sizes_.size());
+    levels_[0].assign(src, src + static_cast<size_t>(size.w) * size.h);
+    for (size_t l = 1; l < sizes_.size(); l++) {
+        levels_[l].resize(static_cast<size_t>(sizes_[l].w) * sizes_[l].h);
+        detail::Downsample(levels_[l - 1].data(), sizes_[l - 1], levels_[l].data(), sizes_[l], downsample);
+    }
+    return true;
+}
+
+inline void aut::Mipmap::Clear() {
+    hash_ = 0;
+    levels_.clear();
+    sizes_.clear();
+}
+
+inline int aut::Mipmap::LevelCount() const {
+    return static_cast<int>(sizes_.size());
+}
+
+inline const aut::PixelRGBA* aut::Mipmap::Level(int level) const {
+    return levels_[level].data();
+}
+
+inline aut::Size2D aut::Mipmap::LevelSize(int level) const {
+    return sizes_[level];
+}
+
+inline size_t aut::Mipmap::Bytes() const {
+    size_t bytes = 0;
+    for (auto &l : levels_)
+        bytes += l.size() * sizeof(PixelRGBA);
+    return bytes;
+}
+
+inline aut::PixelRGBA aut::Mipmap::Sample(float x, float y, float footprint,
+                                          SamplingAddressMode address, SamplingFilterMode filter) const {
+    PixelRGBA32F c;
+    detail::DispatchSampling(address, filter, [&](auto a, auto f) {
+        c = detail::SampleMipmapPremultiplied<decltype(a)::value, decltype(f)::value>(*this, x, y, footprint);
+    });
+    return detail::Unpremultiply(c);
+}
+
+inline aut::MipmapCache::MipmapCache(size_t capacity)
+    : capacity_(std::max(capacity, static_cast<size_t>(1))), use_count_(0) {}
+
+inline const aut::Mipmap& aut::MipmapCache::Get(const void *key, const PixelRGBA *src, Size2D size,
+                                                MipmapDownsample downsample) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        if (entries_.size() >= capacity_) {
+            auto oldest = entries_.begin();
+            for (auto e = entries_.begin(); e != entries_.end(); ++e)
+                if (e->second.last_use < oldest->second.last_use)oldest = e;
+            entries_.erase(oldest);
+        }
+        it = entries_.emplace(key, Entry()).first;
+    }
+    it->second.last_use = ++use_count_;
+    it->second.mipmap.Update(src, size, downsample);
+    return it->second.mipmap;
+}
+
+inline const aut::Mipmap& aut::MipmapCache::Get(const PixelRGBA *src, Size2D size,
+                                                MipmapDownsample downsample) {
+    return Get(static_cast<const void*>(src), src, size, downsample);
+}
+
+inline void aut::MipmapCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+inline aut::MipmapCache& aut::MipmapCache::Default() {
+    static MipmapCache cache;
+    return cache;
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_MIPMAP_H_
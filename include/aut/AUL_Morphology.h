@@ -0,0 +1,256 @@
+/**
+ * @file AUL_Morphology.h
+ * @author SEED264
+ * @brief Van Herk/Gil-Werman morphology
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_MORPHOLOGY_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_MORPHOLOGY_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "./AUL_Enum.h"
+#include "./AUL_Parallel.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Apply a morphology operation to an 8-bit plane (e.g. alpha)
+     * Each line pass uses the van Herk/Gil-Werman algorithm, so the cost
+     * does not depend on the radius. Outside of the image is ignored.
+     *
+     * @param[in,out] data Plane data
+     * @param[in] size Plane size
+     * @param[in] op Operation
+     * @param[in] radius Radius of the structuring element
+     * @param[in] shape Shape of the structuring element
+     */
+    void Morphology(byte *data, Size2D size, MorphologyOp op, int radius,
+                    MorphologyShape shape = kAutShapeRect);
+    /**
+     * Apply a morphology operation with a rectangle of (2 * radius_x + 1) x (2 * radius_y + 1)
+     */
+    void Morphology(byte *data, Size2D size, MorphologyOp op, int radius_x, int radius_y);
+    /**
+     * Apply a morphology operation to every channel of a pixel buffer
+     *
+     * @param[in,out] data Pixel data
+     * @param[in] size Image size
+     * @param[in] op Operation
+     * @param[in] radius Radius of the structuring element
+     * @param[in] shape Shape of the structuring element
+     */
+    void Morphology(PixelRGBA *data, Size2D size, MorphologyOp op, int radius,
+                    MorphologyShape shape = kAutShapeRect);
+    /**
+     * Apply a morphology operation with a rectangle of (2 * radius_x + 1) x (2 * radius_y + 1)
+     */
+    void Morphology(PixelRGBA *data, Size2D size, MorphologyOp op, int radius_x, int radius_y);
+
+    namespace detail {
+        // 1次元の線分による処理 (dxは1行下がる毎の横方向のずれ、horizontalで横方向)
+        struct MorphPass {
+            int radius;
+            int dx;
+            bool horizontal;
+        };
+
+        template<typename T>
+        void TransposeImage(const T *src, T *dst, unsigned int w, unsigned int h);
+        /**
+         * Max (dilate) or min (erode) over segments along (dx, 1)
+         * src and dst must not overlap.
+         */
+        template<bool Dilate>
+        void MorphLine(const byte *src, byte *dst, unsigned int w, unsigned int h, size_t elem,
+                       int radius, int dx);
+        template<typename T>
+        void MorphologyImpl(T *data, Size2D size, MorphologyOp op, const std::vector<MorphPass> &passes);
+        std::vector<MorphPass> MorphPasses(int radius_x, int radius_y, MorphologyShape shape);
+    }
+}
+
+template<typename T>
+inline void aut::detail::TransposeImage(const T *src, T *dst, unsigned int w, unsigned int h) {
+    const unsigned int kTile = 32;
+    ParallelFor(0, (h + kTile - 1) / kTile, [&](size_t ty) {
+        unsigned int y0 = static_cast<unsigned int>(ty) * kTile, y1 = std::min(y0 + kTile, h);
+        for (unsigned int x0 = 0; x0 < w; x0 += kTile) {
+            unsigned int x1 = std::min(x0 + kTile, w);
+            for (unsigned int y = y0; y < y1; y++)
+                for (unsigned int x = x0; x < x1; x++)
+                    dst[static_cast<size_t>(x) * h + y] = src[static_cast<size_t>(y) * w + x];
+        }
+    });
+}
+
+template<bool Dilate>
+inline void aut::detail::MorphLine(const byte *src, byte *dst, unsigned int w, unsigned int h, size_t elem,
+                                   int radius, int dx) {
+    const size_t row_bytes = static_cast<size_t>(w) * elem;
+    if (radius <= 0) {
+        std::memcpy(dst, src, row_bytes * h);
+        return;
+    }
+    const byte neutral = Dilate ? 0 : 255;
+    const auto op = Dilate ? simd::MaxBytes : simd::MinBytes;
+    const int k = 2 * radius + 1;
+    const int rows = (static_cast<int>(h) + 2 * radius + k - 1) / k * k;
+    // 斜めの線分は u = x - dx * y で縦方向の線分に直して処理する
+    const long long u_min = dx > 0 ? -static_cast<long long>(h - 1) : 0;
+    const long long u_max = static_cast<long long>(w) - 1 + (dx < 0 ? h - 1 : 0);
+    const size_t kBand = 64;
+    const size_t bands = static_cast<size_t>((u_max - u_min) / kBand + 1);
+    ParallelFor(0, bands, [&](size_t band) {
+        long long u0 = u_min + static_cast<long long>(band * kBand);
+        size_t bw = static_cast<size_t>(std::min<long long>(kBand, u_max + 1 - u0));
+        size_t bytes = bw * elem;
+        std::vector<byte> g(bytes * rows), hs(bytes * rows), out(bytes);
+        // 行yの帯が画像内で占める範囲を[x0, x1)、帯の中での開始位置をoffsetとして求める
+        auto clip = [&](long long y, long long *x0, long long *x1, size_t *offset) {
+            long long xs = u0 + dx * y;
+            *x0 = std::max(xs, 0ll);
+            *x1 = std::min(xs + static_cast<long long>(bw), static_cast<long long>(w));
+            *offset = static_cast<size_t>(*x0 - xs);
+        };
+        for (int p = 0; p < rows; p++) {
+            byte *line = &g[bytes * p];
+            std::memset(line, neutral, bytes);
+            long long y = p - radius, x0, x1;
+            size_t offset;
+            if (y < 0 || y >= h)continue;
+            clip(y, &x0, &x1, &offset);
+            if (x0 < x1)
+                std::memcpy(line + offset * elem, src + y * row_bytes + x0 * elem, (x1 - x0) * elem);
+        }
+        std::memcpy(hs.data(), g.data(), g.size());
+        // gは区間の先頭からの累積、hsは区間の末尾からの累積
+        for (int p = 1; p < rows; p++)
+            if (p % k)op(&g[bytes * p], &g[bytes * p], &g[bytes * (p - 1)], bytes);
+        for (int p = rows - 2; p >= 0; p--)
+            if (p % k != k - 1)op(&hs[bytes * p], &hs[bytes * p], &hs[bytes * (p + 1)], bytes);
+        for (long long y = 0; y < h; y++) {
+            long long x0, x1;
+            size_t offset;
+            clip(y, &x0, &x1, &offset);
+            if (x0 >= x1)continue;
+            op(out.data(), &hs[bytes * y], &g[bytes * (y + k - 1)], bytes);
+            std::memcpy(dst + y * row_bytes + x0 * elem, out.data() + offset * elem, (x1 - x0) * elem);
+        }
+    });
+}
+
+inline std::vector<aut::detail::MorphPass> aut::detail::MorphPasses(int radius_x, int radius_y,
+                                                                    MorphologyShape shape) {
+    std::vector<MorphPass> passes;
+    if (shape == kAutShapeDisc) {
+        // 正八角形 = 縦横の線分(半径a) + 2方向の斜めの線分(半径b) (a + 2b = r, a + b = r / √2)
+        int r = std::max(radius_x, 0);
+        int b = static_cast<int>(0.29289 * r + 0.5);
+        int a = r - 2 * b;
+        if (a < 1 && b > 0) {
+            // 斜めの線分だけでは格子の半分が埋まらない
+            b--;
+            a += 2;
+        }
+        passes.push_back({ a, 0, true });
+        passes.push_back({ a, 0, false });
+        passes.push_back({ b, 1, false });
+        passes.push_back({ b, -1, false });
+    } else {
+        passes.push_back({ radius_x, 0, true });
+        passes.push_back({ radius_y, 0, false });
+    }
+    return passes;
+}
+
+template<typename T>
+inline void aut::detail::MorphologyImpl(T *data, Size2D size, MorphologyOp op,
+                                        const std::vector<MorphPass> &passes) {
+    if (size.w == 0 || size.h == 0)return;
+    std::vector<T> temp(static_cast<size_t>(size.w) * size.h);
+    T *cur = data, *other = temp.data();
+    auto run = [&](bool dilate) {
+        for (const MorphPass &pass : passes) {
+            if (pass.radius <= 0)continue;
+            auto line = dilate ? MorphLine<true> : MorphLine<false>;
+            if (pass.horizontal) {
+                // 転置して縦方向として処理する
+                TransposeImage(cur, other, size.w, size.h);
+                line(reinterpret_cast<const byte*>(other), reinterpret_cast<byte*>(cur),
+                     size.h, size.w, sizeof(T), pass.radius, 0);
+                TransposeImage(cur, other, size.h, size.w);
+            } else {
+                line(reinterpret_cast<const byte*>(cur), reinterpret_cast<byte*>(other),
+                     size.w, size.h, sizeof(T), pass.radius, pass.dx);
+            }
+            std::swap(cur, other);
+        }
+    };
+    switch (op) {
+    case kAutMorphDilate:
+        run(true);
+        break;
+    case kAutMorphErode:
+        run(false);
+        break;
+    case kAutMorphOpen:
+        run(false);
+        run(true);
+        break;
+    case kAutMorphClose:
+        run(true);
+        run(false);
+        break;
+    }
+    if (cur != data)
+        std::memcpy(data, cur, temp.size() * sizeof(T));
+}
+
+inline void aut::Morphology(byte *data, Size2D size, MorphologyOp op, int radius, MorphologyShape shape) {
+    detail::MorphologyImpl(data, size, op, detail::MorphPasses(radius, radius, shape));
+}
+
+inline void aut::Morphology(byte *data, Size2D size, MorphologyOp op, int radius_x, int radius_y) {
+    detail::MorphologyImpl(data, size, op, detail::MorphPasses(radius_x, radius_y, kAutShapeRect));
+}
+
+inline void aut::Morphology(PixelRGBA *data, Size2D size, MorphologyOp op, int radius, MorphologyShape shape) {
+    detail::MorphologyImpl(data, size, op, detail::MorphPasses(radius, radius, shape));
+}
+
+inline void aut::Morphology(PixelRGBA *data, Size2D size, MorphologyOp op, int radius_x, int radius_y) {
+    detail::MorphologyImpl(data, size, op, detail::MorphPasses(radius_x, radius_y, kAutShapeRect));
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_MORPHOLOGY_H_
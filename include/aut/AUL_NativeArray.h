@@ -0,0 +1,350 @@
+/**
+ * @file AUL_NativeArray.h
+ * @author SEED264
+ * @brief Native arrays shared with Lua as userdata
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_NATIVEARRAY_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_NATIVEARRAY_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <lua.hpp>
+#include "./AUL_Enum.h"
+#include "./AUL_ImagePool.h"
+#include "./AUL_Memory.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Typed array shared between C++ and Lua without copying
+     *
+     * The object lives in a full userdata, so Lua's GC decides its lifetime.
+     * Scripts index it from 1 like a table (arr[i], arr[i] = v, #arr), and
+     * arr.length / arr.stride give the view parameters. An array either owns
+     * its memory (optionally borrowed from ImagePool::Default) or is a view
+     * of memory owned by C++, which must outlive the userdata.
+     */
+    class NativeArray {
+    public:
+        static constexpr const char *kMetatableName = "aut.NativeArray";
+
+        NativeArray(const NativeArray&) = delete;
+        NativeArray& operator=(const NativeArray&) = delete;
+
+        /**
+         * Push a new zero-filled array on the top of the stack
+         *
+         * @param[in] type Element type
+         * @param[in] length Number of elements
+         * @param[in] pooled Borrow the memory from ImagePool::Default
+         *
+         * @return NativeArray* Pushed array (check IsValid for allocation failure)
+         */
+        static NativeArray* New(lua_State *L, NativeArrayType type, size_t length, bool pooled = false);
+        /**
+         * Push a view of memory owned by C++ on the top of the stack
+         *
+         * @param[in] type Element type
+         * @param[in] data First element
+         * @param[in] length Number of elements
+         * @param[in] stride Number of elements from one element to the next
+         *
+         * @return NativeArray* Pushed array
+         */
+        static NativeArray* NewView(lua_State *L, NativeArrayType type, void *data, size_t length,
+                                    size_t stride = 1);
+        /**
+         * Get the array at index, or raise a Lua error if it is not one
+         */
+        static NativeArray* Check(lua_State *L, int index);
+        /**
+         * Get the array at index, or nullptr if it is not one
+         */
+        static NativeArray* To(lua_State *L, int index);
+        static size_t ElementSize(NativeArrayType type);
+
+        /**
+         * Whether the memory is available (false if the allocation failed)
+         */
+        bool IsValid() const;
+        NativeArrayType Type() const;
+        size_t Length() const;
+        size_t Stride() const;
+        void* Data() const;
+        /**
+         * Element i (0-based) of an array whose element type is T
+         */
+        template<typename T>
+        T& At(size_t i) const;
+
+    private:
+        NativeArray(NativeArrayType type, size_t length, size_t stride);
+        ~NativeArray();
+
+        static NativeArray* Create(lua_State *L, NativeArrayType type, size_t length, size_t stride);
+        static void PushMetatable(lua_State *L);
+        static int Index(lua_State *L);
+        static int NewIndex(lua_State *L);
+        static int Len(lua_State *L);
+        static int Gc(lua_State *L);
+        static bool ToIndex(lua_State *L, int index, size_t length, size_t *out);
+
+        void Free();
+        byte* Element(size_t i) const;
+        lua_Number Get(size_t i) const;
+        void Set(size_t i, lua_Number value);
+
+        NativeArrayType type_;
+        byte *data_;
+        size_t length_;
+        size_t stride_;
+        bool owned_;
+        ScratchImage scratch_;
+    };
+}
+
+inline aut::NativeArray::NativeArray(NativeArrayType type, size_t length, size_t stride)
+    : type_(type), data_(nullptr), length_(length), stride_(stride), owned_(false) {}
+
+inline aut::NativeArray::~NativeArray() {
+    Free();
+}
+
+inline void aut::NativeArray::Free() {
+    // 2回呼ばれても何もしないように状態を空にしておく
+    if (owned_)
+        AlignedFree(data_);
+    scratch_.Release();
+    data_ = nullptr;
+    length_ = 0;
+    owned_ = false;
+}
+
+inline size_t aut::NativeArray::ElementSize(NativeArrayType type) {
+    switch (type) {
+    case kAutArrayDouble:
+        return sizeof(double);
+    case kAutArrayPixel:
+        return sizeof(PixelRGBA);
+    default:
+        return 4;
+    }
+}
+
+inline void aut::NativeArray::PushMetatable(lua_State *L) {
+    if (luaL_newmetatable(L, kMetatableName)) {
+        lua_pushcfunction(L, Index);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, NewIndex);
+        lua_setfield(L, -2, "__newindex");
+        lua_pushcfunction(L, Len);
+        lua_setfield(L, -2, "__len");
+        lua_pushcfunction(L, Gc);
+        lua_setfield(L, -2, "__gc");
+        // スクリプトから__gcを直接呼べないようにメタテーブルを隠す
+        lua_pushboolean(L, 0);
+        lua_setfield(L, -2, "__metatable");
+    }
+}
+
+inline aut::NativeArray* aut::NativeArray::Create(lua_State *L, NativeArrayType type, size_t length,
+                                                  size_t stride) {
+    void *mem = lua_newuserdata(L, sizeof(NativeArray));
+    NativeArray *array = new(mem) NativeArray(type, length, stride);
+    PushMetatable(L);
+    lua_setmetatable(L, -2);
+    return array;
+}
+
+inline aut::NativeArray* aut::NativeArray::New(lua_State *L, NativeArrayType type, size_t length, bool pooled) {
+    NativeArray *array = Create(L, type, length, 1);
+    size_t bytes = length * ElementSize(type);
+    if (bytes == 0)return array;
+    if (pooled) {
+        // 1行の画像として借りる (行の先頭は64バイト境界に揃う)
+        size_t pixels = (bytes + sizeof(PixelRGBA) - 1) / sizeof(PixelRGBA);
+        array->scratch_ = ImagePool::Default().Get(Size2D(static_cast<unsigned int>(pixels), 1));
+        if (array->scratch_.IsValid())
+            array->data_ = reinterpret_cast<byte*>(array->scratch_.Data());
+    }
+    if (!array->data_) {
+        array->data_ = static_cast<byte*>(AlignedAlloc(bytes));
+        array->owned_ = array->data_ != nullptr;
+    }
+    if (array->data_)
+        std::memset(array->data_, 0, bytes);
+    else
+        array->length_ = 0;
+    return array;
+}
+
+inline aut::NativeArray* aut::NativeArray::NewView(lua_State *L, NativeArrayType type, void *data, size_t length,
+                                                   size_t stride) {
+    NativeArray *array = Create(L, type, data ? length : 0, stride);
+    array->data_ = static_cast<byte*>(data);
+    return array;
+}
+
+inline aut::NativeArray* aut::NativeArray::Check(lua_State *L, int index) {
+    return static_cast<NativeArray*>(luaL_checkudata(L, index, kMetatableName));
+}
+
+inline aut::NativeArray* aut::NativeArray::To(lua_State *L, int index) {
+    void *p = lua_touserdata(L, index);
+    if (!p || !lua_getmetatable(L, index))return nullptr;
+    luaL_getmetatable(L, kMetatableName);
+    bool same = lua_rawequal(L, -1, -2) != 0;
+    lua_pop(L, 2);
+    return same ? static_cast<NativeArray*>(p) : nullptr;
+}
+
+inline bool aut::NativeArray::IsValid() const {
+    return data_ != nullptr;
+}
+
+inline aut::NativeArrayType aut::NativeArray::Type() const {
+    return type_;
+}
+
+inline size_t aut::NativeArray::Length() const {
+    return length_;
+}
+
+inline size_t aut::NativeArray::Stride() const {
+    return stride_;
+}
+
+inline void* aut::NativeArray::Data() const {
+    return data_;
+}
+
+template<typename T>
+inline T& aut::NativeArray::At(size_t i) const {
+    return *reinterpret_cast<T*>(Element(i));
+}
+
+inline aut::byte* aut::NativeArray::Element(size_t i) const {
+    return data_ + i * stride_ * ElementSize(type_);
+}
+
+inline lua_Number aut::NativeArray::Get(size_t i) const {
+    switch (type_) {
+    case kAutArrayFloat:
+        return At<float>(i);
+    case kAutArrayDouble:
+        return At<double>(i);
+    case kAutArrayInt32:
+        return At<int>(i);
+    default: {
+        const PixelRGBA &p = At<PixelRGBA>(i);
+        return static_cast<lua_Number>(static_cast<unsigned int>(p.a) << 24 | p.r << 16 | p.g << 8 | p.b);
+    }
+    }
+}
+
+inline void aut::NativeArray::Set(size_t i, lua_Number value) {
+    switch (type_) {
+    case kAutArrayFloat:
+        At<float>(i) = static_cast<float>(value);
+        break;
+    case kAutArrayDouble:
+        At<double>(i) = value;
+        break;
+    case kAutArrayInt32:
+        // 範囲外やNaNのキャストは未定義動作なので先に丸めておく
+        if (!(value > -2147483648.0))
+            value = value != value ? 0.0 : -2147483648.0;
+        else if (value > 2147483647.0)
+            value = 2147483647.0;
+        At<int>(i) = static_cast<int>(value);
+        break;
+    default: {
+        if (!(value > 0.0))
+            value = 0.0;
+        else if (value > 4294967295.0)
+            value = 4294967295.0;
+        unsigned int v = static_cast<unsigned int>(value);
+        At<PixelRGBA>(i) = PixelRGBA((v >> 16) & 0xFF, (v >> 8) & 0xFF, v & 0xFF, v >> 24);
+        break;
+    }
+    }
+}
+
+inline int aut::NativeArray::Index(lua_State *L) {
+    NativeArray *array = Check(L, 1);
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        size_t i;
+        if (ToIndex(L, 2, array->length_, &i))
+            lua_pushnumber(L, array->Get(i));
+        else
+            lua_pushnil(L);
+        return 1;
+    }
+    const char *key = lua_tostring(L, 2);
+    if (key && std::strcmp(key, "length") == 0)
+        lua_pushnumber(L, static_cast<lua_Number>(array->length_));
+    else if (key && std::strcmp(key, "stride") == 0)
+        lua_pushnumber(L, static_cast<lua_Number>(array->stride_));
+    else
+        lua_pushnil(L);
+    return 1;
+}
+
+inline int aut::NativeArray::NewIndex(lua_State *L) {
+    NativeArray *array = Check(L, 1);
+    size_t i;
+    if (!ToIndex(L, 2, array->length_, &i))
+        return luaL_error(L, "NativeArray index out of range or not an integer");
+    array->Set(i, luaL_checknumber(L, 3));
+    return 0;
+}
+
+inline bool aut::NativeArray::ToIndex(lua_State *L, int index, size_t length, size_t *out) {
+    // 小数の添字は切り捨てると別の要素を指してしまうので弾く
+    if (lua_type(L, index) != LUA_TNUMBER)return false;
+    lua_Number i = lua_tonumber(L, index);
+    if (!(i >= 1) || i > static_cast<lua_Number>(length) || std::floor(i) != i)return false;
+    *out = static_cast<size_t>(i) - 1;
+    return true;
+}
+
+inline int aut::NativeArray::Len(lua_State *L) {
+    lua_pushnumber(L, static_cast<lua_Number>(Check(L, 1)->length_));
+    return 1;
+}
+
+inline int aut::NativeArray::Gc(lua_State *L) {
+    Check(L, 1)->Free();
+    return 0;
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_NATIVEARRAY_H_
@@ -0,0 +1,578 @@
+/**
+ * @file AUL_Noise.h
+ * @author SEED264
+ * @brief Simplex noise and fractal Brownian motion
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_NOISE_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_NOISE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include "./AUL_Parallel.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    // ノイズの生成パラメータ用の構造体
+    struct NoiseParam {
+        int seed;
+        int octaves;
+        float frequency;
+        float lacunarity;
+        float gain;
+
+        NoiseParam(int aseed, int aoctaves, float afrequency, float alacunarity, float again)
+            : seed(aseed), octaves(aoctaves), frequency(afrequency),
+              lacunarity(alacunarity), gain(again) {}
+        NoiseParam() : NoiseParam(0, 1, 1.f / 64, 2.f, 0.5f) {}
+    };
+
+    /**
+     * 2D simplex noise
+     *
+     * @param[in] seed Random seed
+     *
+     * @return float Noise value (about -1 ~ 1)
+     */
+    float SimplexNoise(float x, float y, int seed = 0);
+    /**
+     * 3D simplex noise
+     *
+     * @param[in] seed Random seed
+     *
+     * @return float Noise value (about -1 ~ 1)
+     */
+    float SimplexNoise(float x, float y, float z, int seed = 0);
+    /**
+     * 4D simplex noise
+     *
+     * @param[in] seed Random seed
+     *
+     * @return float Noise value (about -1 ~ 1)
+     */
+    float SimplexNoise(float x, float y, float z, float w, int seed = 0);
+    /**
+     * 2D fractal Brownian motion of simplex noise
+     * Coordinates are multiplied by param.frequency.
+     *
+     * @return float Noise value (about -1 ~ 1)
+     */
+    float FractalNoise(float x, float y, const NoiseParam &param);
+    /**
+     * 3D fractal Brownian motion of simplex noise
+     *
+     * @return float Noise value (about -1 ~ 1)
+     */
+    float FractalNoise(float x, float y, float z, const NoiseParam &param);
+    /**
+     * 4D fractal Brownian motion of simplex noise
+     *
+     * @return float Noise value (about -1 ~ 1)
+     */
+    float FractalNoise(float x, float y, float z, float w, const NoiseParam &param);
+
+    /**
+     * Fill a buffer with 2D fractal noise
+     * out[y * size.w + x] = FractalNoise(x + offset.x, y + offset.y, param)
+     * Rows are processed in parallel.
+     *
+     * @param[out] out Destination buffer (size.w * size.h)
+     * @param[in] size Buffer size
+     * @param[in] param Noise parameters
+     * @param[in] offset Offset added to the pixel coords
+     */
+    void FillNoise(float *out, Size2D size, const NoiseParam &param,
+                   glm::dvec2 offset = glm::dvec2(0));
+    /**
+     * Fill a buffer with a slice of 3D fractal noise
+     * out[y * size.w + x] = FractalNoise(x + offset.x, y + offset.y, z, param)
+     * Rows are processed in parallel.
+     *
+     * @param[out] out Destination buffer (size.w * size.h)
+     * @param[in] size Buffer size
+     * @param[in] param Noise parameters
+     * @param[in] z Z coord of the slice (e.g. time for animated noise)
+     * @param[in] offset Offset added to the pixel coords
+     */
+    void FillNoise(float *out, Size2D size, const NoiseParam &param,
+                   float z, glm::dvec2 offset = glm::dvec2(0));
+    /**
+     * Fill a buffer with 2D fractal noise as grayscale
+     * -1 ~ 1 is mapped to 0 ~ 255, alpha is set to 255.
+     *
+     * @param[out] out Destination buffer (size.w * size.h)
+     * @param[in] size Buffer size
+     * @param[in] param Noise parameters
+     * @param[in] offset Offset added to the pixel coords
+     */
+    void FillNoise(PixelRGBA *out, Size2D size, const NoiseParam &param,
+                   glm::dvec2 offset = glm::dvec2(0));
+    /**
+     * Fill a buffer with a slice of 3D fractal noise as grayscale
+     * -1 ~ 1 is mapped to 0 ~ 255, alpha is set to 255.
+     *
+     * @param[out] out Destination buffer (size.w * size.h)
+     * @param[in] size Buffer size
+     * @param[in] param Noise parameters
+     * @param[in] z Z coord of the slice (e.g. time for animated noise)
+     * @param[in] offset Offset added to the pixel coords
+     */
+    void FillNoise(PixelRGBA *out, Size2D size, const NoiseParam &param,
+                   float z, glm::dvec2 offset = glm::dvec2(0));
+    /**
+     * Evaluate fractal noise at each point
+     *
+     * @param[in] points Sample points
+     * @param[in] param Noise parameters
+     *
+     * @return std::vector<float> Noise value of each point
+     */
+    std::vector<float> EvaluateNoise(const std::vector<glm::dvec2> &points, const NoiseParam &param);
+    /**
+     * Evaluate fractal noise at each point
+     *
+     * @param[in] points Sample points
+     * @param[in] param Noise parameters
+     *
+     * @return std::vector<float> Noise value of each point
+     */
+    std::vector<float> EvaluateNoise(const std::vector<glm::dvec3> &points, const NoiseParam &param);
+    /**
+     * Displace each point by a noise vector field
+     * Each component uses a different seed derived from param.seed.
+     *
+     * @param[in,out] points Points to displace
+     * @param[in] param Noise parameters
+     * @param[in] amount Displacement of noise value 1
+     * @param[in] z Z coord of the slice (e.g. time for animated noise)
+     */
+    void DisplaceByNoise(std::vector<glm::dvec2> &points, const NoiseParam &param,
+                         double amount, float z = 0);
+    /**
+     * Displace each point by a noise vector field
+     * Each component uses a different seed derived from param.seed.
+     *
+     * @param[in,out] points Points to displace
+     * @param[in] param Noise parameters
+     * @param[in] amount Displacement of noise value 1
+     * @param[in] w W coord of the slice (e.g. time for animated noise)
+     */
+    void DisplaceByNoise(std::vector<glm::dvec3> &points, const NoiseParam &param,
+                         double amount, float w = 0);
+
+    namespace detail {
+        simd::VUInt NoiseHash(simd::VUInt i, simd::VUInt j, simd::VUInt k, simd::VUInt l, uint seed);
+        simd::VFloat Simplex2(simd::VFloat x, simd::VFloat y, uint seed);
+        simd::VFloat Simplex3(simd::VFloat x, simd::VFloat y, simd::VFloat z, uint seed);
+        simd::VFloat Simplex4(simd::VFloat x, simd::VFloat y, simd::VFloat z, simd::VFloat w, uint seed);
+        simd::VFloat Fractal2(simd::VFloat x, simd::VFloat y, const NoiseParam &param);
+        simd::VFloat Fractal3(simd::VFloat x, simd::VFloat y, simd::VFloat z, const NoiseParam &param);
+        simd::VFloat Fractal4(simd::VFloat x, simd::VFloat y, simd::VFloat z, simd::VFloat w,
+                              const NoiseParam &param);
+        float FirstLane(simd::VFloat a);
+        // 行ごとに並列でノイズを評価し、8画素ずつwriteに渡す
+        template<typename Eval, typename Write>
+        void ForEachNoiseRow(Size2D size, glm::dvec2 offset, Eval eval, Write write);
+        byte NoiseToByte(float value);
+    }
+}
+
+inline aut::simd::VUInt aut::detail::NoiseHash(simd::VUInt i, simd::VUInt j, simd::VUInt k,
+                                               simd::VUInt l, uint seed) {
+    using namespace simd;
+    VUInt h = i * Set1(0x8DA6B343u) + j * Set1(0xD8163841u)
+            + k * Set1(0xCB1AB31Fu) + l * Set1(0x165667B1u) + Set1(seed * 0x9E3779B9u);
+    h = h ^ ShiftRight(h, 15);
+    h = h * Set1(0x2C1B3C6Du);
+    h = h ^ ShiftRight(h, 12);
+    h = h * Set1(0x297A2D39u);
+    return h ^ ShiftRight(h, 15);
+}
+
+inline aut::simd::VFloat aut::detail::Simplex2(simd::VFloat x, simd::VFloat y, uint seed) {
+    using namespace simd;
+    const float F2 = 0.366025403f;  // (sqrt(3) - 1) / 2
+    const float G2 = 0.211324865f;  // (3 - sqrt(3)) / 6
+    const VFloat zero = Set1(0.f), one = Set1(1.f);
+
+    VFloat s = (x + y) * Set1(F2);
+    VFloat i = Floor(x + s), j = Floor(y + s);
+    VFloat t = (i + j) * Set1(G2);
+    VFloat x0 = x - (i - t), y0 = y - (j - t);
+    // 単体のどちらの三角形に属するか
+    VMask lower = x0 > y0;
+    VFloat i1 = Select(lower, one, zero), j1 = Select(lower, zero, one);
+    VFloat x1 = x0 - i1 + Set1(G2), y1 = y0 - j1 + Set1(G2);
+    VFloat x2 = x0 - one + Set1(2 * G2), y2 = y0 - one + Set1(2 * G2);
+
+    VUInt ii = ToInt(i), jj = ToInt(j), zi = Set1(0u);
+    VUInt h[3] = {
+        NoiseHash(ii, jj, zi, zi, seed),
+        NoiseHash(ii + ToInt(i1), jj + ToInt(j1), zi, zi, seed),
+        NoiseHash(ii + Set1(1u), jj + Set1(1u), zi, zi, seed)
+    };
+    VFloat px[3] = { x0, x1, x2 }, py[3] = { y0, y1, y2 };
+    VFloat n = zero;
+    for (int c = 0; c < 3; c++) {
+        VFloat tc = Max(Set1(0.5f) - px[c] * px[c] - py[c] * py[c], zero);
+        tc = tc * tc;
+        // 8方向の勾配との内積
+        VMask swap = TestBits(h[c], 4);
+        VFloat u = Select(swap, py[c], px[c]), v = Select(swap, px[c], py[c]);
+        VFloat g = Select(TestBits(h[c], 1), -u, u) + Select(TestBits(h[c], 2), -v, v) * Set1(2.f);
+        n = n + tc * tc * g;
+    }
+    return n * Set1(40.f);
+}
+
+inline aut::simd::VFloat aut::detail::Simplex3(simd::VFloat x, simd::VFloat y, simd::VFloat z, uint seed) {
+    using namespace simd;
+    const float F3 = 1.f / 3;
+    const float G3 = 1.f / 6;
+    const VFloat zero = Set1(0.f), one = Set1(1.f);
+
+    VFloat s = (x + y + z) * Set1(F3);
+    VFloat i = Floor(x + s), j = Floor(y + s), k = Floor(z + s);
+    VFloat t = (i + j + k) * Set1(G3);
+    VFloat x0 = x - (i - t), y0 = y - (j - t), z0 = z - (k - t);
+    // 各軸の大小関係の順位から単体の頂点を決める
+    VMask xy = x0 >= y0, xz = x0 >= z0, yz = y0 >= z0;
+    VFloat rx = Select(xy, one, zero) + Select(xz, one, zero);
+    VFloat ry = Select(xy, zero, one) + Select(yz, one, zero);
+    VFloat rz = Select(xz, zero, one) + Select(yz, zero, one);
+    VFloat two = Set1(2.f);
+    VFloat i1 = Select(rx >= two, one, zero), i2 = Select(rx >= one, one, zero);
+    VFloat j1 = Select(ry >= two, one, zero), j2 = Select(ry >= one, one, zero);
+    VFloat k1 = Select(rz >= two, one, zero), k2 = Select(rz >= one, one, zero);
+
+    VFloat px[4] = { x0, x0 - i1 + Set1(G3), x0 - i2 + Set1(2 * G3), x0 - one + Set1(3 * G3) };
+    VFloat py[4] = { y0, y0 - j1 + Set1(G3), y0 - j2 + Set1(2 * G3), y0 - one + Set1(3 * G3) };
+    VFloat pz[4] = { z0, z0 - k1 + Set1(G3), z0 - k2 + Set1(2 * G3), z0 - one + Set1(3 * G3) };
+    VUInt ii = ToInt(i), jj = ToInt(j), kk = ToInt(k), zi = Set1(0u), oi = Set1(1u);
+    VUInt h[4] = {
+        NoiseHash(ii, jj, kk, zi, seed),
+        NoiseHash(ii + ToInt(i1), jj + ToInt(j1), kk + ToInt(k1), zi, seed),
+        NoiseHash(ii + ToInt(i2), jj + ToInt(j2), kk + ToInt(k2), zi, seed),
+        NoiseHash(ii + oi, jj + oi, kk + oi, zi, seed)
+    };
+    VFloat n = zero;
+    for (int c = 0; c < 4; c++) {
+        VFloat tc = Max(Set1(0.6f) - px[c] * px[c] - py[c] * py[c] - pz[c] * pz[c], zero);
+        tc = tc * tc;
+        // 12方向(+4の重複)の勾配との内積
+        VUInt hc = h[c] & Set1(15u);
+        VFloat u = Select(TestBits(hc, 8), py[c], px[c]);
+        VFloat v = Select(!TestBits(hc, 12), py[c],
+                          Select((hc & Set1(13u)) == Set1(12u), px[c], pz[c]));
+        VFloat g = Select(TestBits(hc, 1), -u, u) + Select(TestBits(hc, 2), -v, v);
+        n = n + tc * tc * g;
+    }
+    return n * Set1(32.f);
+}
+
+inline aut::simd::VFloat aut::detail::Simplex4(simd::VFloat x, simd::VFloat y, simd::VFloat z,
+                                               simd::VFloat w, uint seed) {
+    using namespace simd;
+    const float F4 = 0.309016994f;  // (sqrt(5) - 1) / 4
+    const float G4 = 0.138196601f;  // (5 - sqrt(5)) / 20
+    const VFloat zero = Set1(0.f), one = Set1(1.f);
+
+    VFloat s = (x + y + z + w) * Set1(F4);
+    VFloat i = Floor(x + s), j = Floor(y + s), k = Floor(z + s), l = Floor(w + s);
+    VFloat t = (i + j + k + l) * Set1(G4);
+    VFloat p0[4] = { x - (i - t), y - (j - t), z - (k - t), w - (l - t) };
+    // 各軸の大小関係の順位から単体の頂点を決める
+    VFloat rank[4] = { zero, zero, zero, zero };
+    for (int a = 0; a < 4; a++) {
+        for (int b = a + 1; b < 4; b++) {
+            VMask gt = p0[a] > p0[b];
+            rank[a] = rank[a] + Select(gt, one, zero);
+            rank[b] = rank[b] + Select(gt, zero, one);
+        }
+    }
+    VFloat p[5][4];
+    VUInt cell[5][4];
+    VUInt base[4] = { ToInt(i), ToInt(j), ToInt(k), ToInt(l) };
+    for (int a = 0; a < 4; a++) {
+        p[0][a] = p0[a];
+        cell[0][a] = base[a];
+        for (int c = 1; c <= 4; c++) {
+            VFloat offset = Select(rank[a] >= Set1(static_cast<float>(4 - c)), one, zero);
+            p[c][a] = p0[a] - offset + Set1(c * G4);
+            cell[c][a] = base[a] + ToInt(offset);
+        }
+    }
+    VFloat n = zero;
+    for (int c = 0; c < 5; c++) {
+        VFloat tc = Max(Set1(0.6f) - p[c][0] * p[c][0] - p[c][1] * p[c][1]
+                                   - p[c][2] * p[c][2] - p[c][3] * p[c][3], zero);
+        tc = tc * tc;
+        // 32方向の勾配との内積
+        VUInt h = NoiseHash(cell[c][0], cell[c][1], cell[c][2], cell[c][3], seed) & Set1(31u);
+        VUInt h24 = h & Set1(24u);
+        VFloat u = Select(h24 == Set1(24u), p[c][1], p[c][0]);
+        VFloat v = Select(TestBits(h, 16), p[c][2], p[c][1]);
+        VFloat r = Select(h24 == Set1(0u), p[c][2], p[c][3]);
+        VFloat g = Select(TestBits(h, 1), -u, u) + Select(TestBits(h, 2), -v, v)
+                 + Select(TestBits(h, 4), -r, r);
+        n = n + tc * tc * g;
+    }
+    return n * Set1(27.f);
+}
+
+inline aut::simd::VFloat aut::detail::Fractal2(simd::VFloat x, simd::VFloat y, const NoiseParam &param) {
+    using namespace simd;
+    VFloat sum = Set1(0.f);
+    float freq = param.frequency, amp = 1.f, amp_sum = 0.f;
+    for (int o = 0; o < std::max(param.octaves, 1); o++) {
+        VFloat f = Set1(freq);
+        sum = sum + Simplex2(x * f, y * f, static_cast<uint>(param.seed + o)) * Set1(amp);
+        amp_sum += amp;
+        freq *= param.lacunarity;
+        amp *= param.gain;
+    }
+    return sum * Set1(1.f / amp_sum);
+}
+
+inline aut::simd::VFloat aut::detail::Fractal3(simd::VFloat x, simd::VFloat y, simd::VFloat z,
+                                               const NoiseParam &param) {
+    using namespace simd;
+    VFloat sum = Set1(0.f);
+    float freq = param.frequency, amp = 1.f, amp_sum = 0.f;
+    for (int o = 0; o < std::max(param.octaves, 1); o++) {
+        VFloat f = Set1(freq);
+        sum = sum + Simplex3(x * f, y * f, z * f, static_cast<uint>(param.seed + o)) * Set1(amp);
+        amp_sum += amp;
+        freq *= param.lacunarity;
+        amp *= param.gain;
+    }
+    return sum * Set1(1.f / amp_sum);
+}
+
+inline aut::simd::VFloat aut::detail::Fractal4(simd::VFloat x, simd::VFloat y, simd::VFloat z,
+                                               simd::VFloat w, const NoiseParam &param) {
+    using namespace simd;
+    VFloat sum = Set1(0.f);
+    float freq = param.frequency, amp = 1.f, amp_sum = 0.f;
+    for (int o = 0; o < std::max(param.octaves, 1); o++) {
+        VFloat f = Set1(freq);
+        sum = sum + Simplex4(x * f, y * f, z * f, w * f, static_cast<uint>(param.seed + o)) * Set1(amp);
+        amp_sum += amp;
+        freq *= param.lacunarity;
+        amp *= param.gain;
+    }
+    return sum * Set1(1.f / amp_sum);
+}
+
+inline float aut::detail::FirstLane(simd::VFloat a) {
+    float lanes[simd::kLanes];
+    simd::Store(lanes, a);
+    return lanes[0];
+}
+
+inline aut::byte aut::detail::NoiseToByte(float value) {
+    float v = (value * 0.5f + 0.5f) * 255.f + 0.5f;
+    return static_cast<byte>(std::min(std::max(v, 0.f), 255.f));
+}
+
+inline float aut::SimplexNoise(float x, float y, int seed) {
+    using namespace simd;
+    return detail::FirstLane(detail::Simplex2(Set1(x), Set1(y), static_cast<uint>(seed)));
+}
+
+inline float aut::SimplexNoise(float x, float y, float z, int seed) {
+    using namespace simd;
+    return detail::FirstLane(detail::Simplex3(Set1(x), Set1(y), Set1(z), static_cast<uint>(seed)));
+}
+
+inline float aut::SimplexNoise(float x, float y, float z, float w, int seed) {
+    using namespace simd;
+    return detail::FirstLane(detail::Simplex4(Set1(x), Set1(y), Set1(z), Set1(w),
+                                              static_cast<uint>(seed)));
+}
+
+inline float aut::FractalNoise(float x, float y, const NoiseParam &param) {
+    using namespace simd;
+    return detail::FirstLane(detail::Fractal2(Set1(x), Set1(y), param));
+}
+
+inline float aut::FractalNoise(float x, float y, float z, const NoiseParam &param) {
+    using namespace simd;
+    return detail::FirstLane(detail::Fractal3(Set1(x), Set1(y), Set1(z), param));
+}
+
+inline float aut::FractalNoise(float x, float y, float z, float w, const NoiseParam &param) {
+    using namespace simd;
+    return detail::FirstLane(detail::Fractal4(Set1(x), Set1(y), Set1(z), Set1(w), param));
+}
+
+template<typename Eval, typename Write>
+inline void aut::detail::ForEachNoiseRow(Size2D size, glm::dvec2 offset, Eval eval, Write write) {
+    using namespace simd;
+    ParallelFor(0, size.h, [&](size_t y) {
+        VFloat vy = Set1(static_cast<float>(y + offset.y));
+        float lanes[kLanes];
+        for (size_t x = 0; x < size.w; x += kLanes) {
+            VFloat vx = ToFloat(Iota(static_cast<uint>(x))) + Set1(static_cast<float>(offset.x));
+            Store(lanes, eval(vx, vy));
+            write(y * size.w + x, lanes, std::min(kLanes, size.w - x));
+        }
+    });
+}
+
+inline void aut::FillNoise(float *out, Size2D size, const NoiseParam &param, glm::dvec2 offset) {
+    detail::ForEachNoiseRow(size, offset,
+        [&](simd::VFloat x, simd::VFloat y) { return detail::Fractal2(x, y, param); },
+        [&](size_t pos, const float *lanes, size_t n) { std::copy(lanes, lanes + n, out + pos); });
+}
+
+inline void aut::FillNoise(float *out, Size2D size, const NoiseParam &param,
+                           float z, glm::dvec2 offset) {
+    simd::VFloat vz = simd::Set1(z);
+    detail::ForEachNoiseRow(size, offset,
+        [&](simd::VFloat x, simd::VFloat y) { return detail::Fractal3(x, y, vz, param); },
+        [&](size_t pos, const float *lanes, size_t n) { std::copy(lanes, lanes + n, out + pos); });
+}
+
+inline void aut::FillNoise(PixelRGBA *out, Size2D size, const NoiseParam &param, glm::dvec2 offset) {
+    detail::ForEachNoiseRow(size, offset,
+        [&](simd::VFloat x, simd::VFloat y) { return detail::Fractal2(x, y, param); },
+        [&](size_t pos, const float *lanes, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                byte v = detail::NoiseToByte(lanes[i]);
+                out[pos + i] = PixelRGBA(v, v, v, 255);
+            }
+        });
+}
+
+inline void aut::FillNoise(PixelRGBA *out, Size2D size, const NoiseParam &param,
+                           float z, glm::dvec2 offset) {
+    simd::VFloat vz = simd::Set1(z);
+    detail::ForEachNoiseRow(size, offset,
+        [&](simd::VFloat x, simd::VFloat y) { return detail::Fractal3(x, y, vz, param); },
+        [&](size_t pos, const float *lanes, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                byte v = detail::NoiseToByte(lanes[i]);
+                out[pos + i] = PixelRGBA(v, v, v, 255);
+            }
+        });
+}
+
+inline std::vector<float> aut::EvaluateNoise(const std::vector<glm::dvec2> &points,
+                                             const NoiseParam &param) {
+    using namespace simd;
+    std::vector<float> out(points.size());
+    size_t block_num = (points.size() + kLanes - 1) / kLanes;
+    ParallelFor(0, block_num, [&](size_t b) {
+        float px[kLanes] = {}, py[kLanes] = {}, lanes[kLanes];
+        size_t first = b * kLanes, n = std::min(kLanes, points.size() - first);
+        for (size_t i = 0; i < n; i++) {
+            px[i] = static_cast<float>(points[first + i].x);
+            py[i] = static_cast<float>(points[first + i].y);
+        }
+        Store(lanes, detail::Fractal2(Load(px), Load(py), param));
+        std::copy(lanes, lanes + n, out.begin() + first);
+    }, 64);
+    return out;
+}
+
+inline std::vector<float> aut::EvaluateNoise(const std::vector<glm::dvec3> &points,
+                                             const NoiseParam &param) {
+    using namespace simd;
+    std::vector<float> out(points.size());
+    size_t block_num = (points.size() + kLanes - 1) / kLanes;
+    ParallelFor(0, block_num, [&](size_t b) {
+        float px[kLanes] = {}, py[kLanes] = {}, pz[kLanes] = {}, lanes[kLanes];
+        size_t first = b * kLanes, n = std::min(kLanes, points.size() - first);
+        for (size_t i = 0; i < n; i++) {
+            px[i] = static_cast<float>(points[first + i].x);
+            py[i] = static_cast<float>(points[first + i].y);
+            pz[i] = static_cast<float>(points[first + i].z);
+        }
+        Store(lanes, detail::Fractal3(Load(px), Load(py), Load(pz), param));
+        std::copy(lanes, lanes + n, out.begin() + first);
+    }, 64);
+    return out;
+}
+
+inline void aut::DisplaceByNoise(std::vector<glm::dvec2> &points, const NoiseParam &param,
+                                 double amount, float z) {
+    using namespace simd;
+    size_t block_num = (points.size() + kLanes - 1) / kLanes;
+    ParallelFor(0, block_num, [&](size_t b) {
+        float px[kLanes] = {}, py[kLanes] = {}, dx[kLanes], dy[kLanes];
+        size_t first = b * kLanes, n = std::min(kLanes, points.size() - first);
+        for (size_t i = 0; i < n; i++) {
+            px[i] = static_cast<float>(points[first + i].x);
+            py[i] = static_cast<float>(points[first + i].y);
+        }
+        NoiseParam param_y = param;
+        param_y.seed += 0x1000;
+        VFloat vz = Set1(z);
+        Store(dx, detail::Fractal3(Load(px), Load(py), vz, param));
+        Store(dy, detail::Fractal3(Load(px), Load(py), vz, param_y));
+        for (size_t i = 0; i < n; i++) {
+            points[first + i].x += dx[i] * amount;
+            points[first + i].y += dy[i] * amount;
+        }
+    }, 64);
+}
+
+inline void aut::DisplaceByNoise(std::vector<glm::dvec3> &points, const NoiseParam &param,
+                                 double amount, float w) {
+    using namespace simd;
+    size_t block_num = (points.size() + kLanes - 1) / kLanes;
+    ParallelFor(0, block_num, [&](size_t b) {
+        float px[kLanes] = {}, py[kLanes] = {}, pz[kLanes] = {};
+        float d[3][kLanes];
+        size_t first = b * kLanes, n = std::min(kLanes, points.size() - first);
+        for (size_t i = 0; i < n; i++) {
+            px[i] = static_cast<float>(points[first + i].x);
+            py[i] = static_cast<float>(points[first + i].y);
+            pz[i] = static_cast<float>(points[first + i].z);
+        }
+        VFloat vw = Set1(w);
+        for (int c = 0; c < 3; c++) {
+            NoiseParam param_c = param;
+            param_c.seed += 0x1000 * c;
+            Store(d[c], detail::Fractal4(Load(px), Load(py), Load(pz), vw, param_c));
+        }
+        for (size_t i = 0; i < n; i++) {
+            points[first + i].x += d[0][i] * amount;
+            points[first + i].y += d[1][i] * amount;
+            points[first + i].z += d[2][i] * amount;
+        }
+    }, 64);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_NOISE_H_
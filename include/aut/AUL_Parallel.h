@@ -0,0 +1,133 @@
+/**
+ * @file AUL_Parallel.h
+ * @author SEED264
+ * @brief Simple fork-join helpers for the native kernels
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_PARALLEL_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Get the number of threads used by ParallelFor
+     *
+     * @return uint Number of threads (1 or more)
+     */
+    uint GetThreadCount();
+    /**
+     * Set the number of threads used by ParallelFor
+     *
+     * @param[in] count Number of threads (0 = number of logical processors)
+     */
+    void SetThreadCount(uint count);
+    /**
+     * Call func(i) for each i in [begin, end) on multiple threads
+     * Threads are created for each call and joined before returning, so no
+     * thread is left running while the script DLL is unloaded.
+     * If a thread cannot be created the caller runs the remaining indices.
+     * The first exception thrown by func stops the loop and is rethrown on
+     * the calling thread after every thread has been joined.
+     *
+     * @param[in] begin First index
+     * @param[in] end Last index + 1
+     * @param[in] func Function called with each index
+     * @param[in] grain Number of indices a thread takes at once
+     */
+    template<typename Func>
+    void ParallelFor(size_t begin, size_t end, Func func, size_t grain = 1);
+
+    namespace detail {
+        inline std::atomic<uint>& ThreadCountSetting() {
+            static std::atomic<uint> count(0);
+            return count;
+        }
+    }
+}
+
+inline aut::uint aut::GetThreadCount() {
+    uint count = detail::ThreadCountSetting().load();
+    if (count == 0)
+        count = std::thread::hardware_concurrency();
+    return std::max(count, 1u);
+}
+
+inline void aut::SetThreadCount(uint count) {
+    detail::ThreadCountSetting().store(count);
+}
+
+template<typename Func>
+inline void aut::ParallelFor(size_t begin, size_t end, Func func, size_t grain) {
+    if (end <= begin)return;
+    grain = std::max<size_t>(grain, 1);
+    size_t chunk_num = (end - begin + grain - 1) / grain;
+    size_t thread_num = std::min<size_t>(GetThreadCount(), chunk_num);
+    if (thread_num <= 1) {
+        for (size_t i = begin; i < end; i++) func(i);
+        return;
+    }
+    std::atomic<size_t> next(begin);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&]() {
+        // 例外をスレッドの外に出すとstd::terminateになるので捕まえて呼び出し元で投げ直す
+        try {
+            while (true) {
+                size_t first = next.fetch_add(grain);
+                if (first >= end)break;
+                size_t last = std::min(first + grain, end);
+                for (size_t i = first; i < last; i++) func(i);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)error = std::current_exception();
+            next.store(end);
+        }
+    };
+    std::vector<std::thread> threads;
+    try {
+        threads.reserve(thread_num - 1);
+        for (size_t i = 1; i < thread_num; i++) threads.emplace_back(worker);
+    } catch (...) {
+        // スレッドを作れなかった分は呼び出し元のworkerが処理する
+    }
+    worker();
+    for (auto &t : threads) t.join();
+    if (error)std::rethrow_exception(error);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_PARALLEL_H_
@@ -0,0 +1,369 @@
+/**
+ * @file AUL_Particles.h
+ * @author SEED264
+ * @brief Particle system with batched drawing
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_PARTICLES_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_PARTICLES_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <lua.hpp>
+#include "./AUL_Parallel.h"
+#include "./AUL_Random.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+#include "./AUL_Wrapper.h"
+
+namespace aut {
+    // パーティクルの発生条件 (時間の単位は秒)
+    struct ParticleEmitter {
+        // 発生位置の中心
+        float x, y, z;
+        // 発生位置の範囲 (中心から±)
+        float range_x, range_y, range_z;
+        // 初速 (ピクセル/秒)
+        float vx, vy, vz;
+        // 初速のばらつき (各軸±)
+        float speed_spread;
+        // 1秒あたりの発生数
+        float rate;
+        // 発生を始める時刻
+        float start;
+        // 発生し続ける時間 (負数で無制限)
+        float duration;
+        // 寿命とそのばらつき (±)
+        float life, life_spread;
+        // 拡大率の発生時と消滅時の値
+        float zoom_begin, zoom_end;
+        // 不透明度の発生時と消滅時の値
+        float alpha_begin, alpha_end;
+        // 回転角の初期値のばらつき (±度)
+        float rotation_spread;
+        // 回転速度のばらつき (±度/秒)
+        float spin_spread;
+
+        ParticleEmitter()
+            : x(0), y(0), z(0), range_x(0), range_y(0), range_z(0),
+              vx(0), vy(0), vz(0), speed_spread(100), rate(100), start(0), duration(-1),
+              life(2), life_spread(0), zoom_begin(1), zoom_end(1), alpha_begin(1), alpha_end(0),
+              rotation_spread(0), spin_spread(0) {}
+    };
+
+    // パーティクルに働く力
+    struct ParticleForces {
+        // 重力加速度 (ピクセル/秒^2)
+        float gravity_x, gravity_y, gravity_z;
+        // 風速 (dragが0なら影響しない)
+        float wind_x, wind_y, wind_z;
+        // 空気抵抗の係数 (1/秒)
+        float drag;
+
+        ParticleForces()
+            : gravity_x(0), gravity_y(0), gravity_z(0), wind_x(0), wind_y(0), wind_z(0), drag(0) {}
+    };
+
+    /**
+     * Particle system evaluated in closed form
+     *
+     * Every particle is identified by its emission index, and its random
+     * attributes come from RandomFloat(seed, attribute, index). Its state at
+     * a given time is computed analytically from the forces, so any frame
+     * can be evaluated directly, in any order, with the same result as
+     * playback. Particles are stored as structure of arrays and updated in
+     * parallel with the SIMD layer.
+     */
+    class ParticleSystem {
+    public:
+        ParticleSystem();
+
+        void SetEmitter(const ParticleEmitter &emitter);
+        void SetForces(const ParticleForces &forces);
+        const ParticleEmitter& GetEmitter() const;
+        const ParticleForces& GetForces() const;
+
+        /**
+         * Compute the particles alive at time
+         *
+         * @param[in] time Time in seconds (e.g. obj.time)
+         * @param[in] seed Seed of the random attributes
+         * @param[in] max_count Maximum number of particles (the oldest are dropped)
+         *
+         * @return size_t Number of alive particles
+         */
+        size_t Evaluate(double time, int seed, size_t max_count = 1000000);
+        size_t Count() const;
+        const float* X() const;
+        const float* Y() const;
+        const float* Z() const;
+        const float* Zoom() const;
+        const float* Alpha() const;
+        /**
+         * Rotation around the Z axis in degrees
+         */
+        const float* Rotation() const;
+        /**
+         * Draw every particle with obj.draw
+         * obj.draw is looked up once for the whole batch.
+         */
+        void Draw(lua_State *L) const;
+        /**
+         * Draw every particle as a quad with obj.drawpoly
+         * The quad faces the screen and maps the whole current image.
+         *
+         * @param[in] image_size Size of the current object image (obj.w, obj.h)
+         */
+        void DrawPoly(lua_State *L, Size2D image_size) const;
+
+    private:
+        static constexpr size_t kChunk = 1024;
+
+        size_t EvaluateChunk(size_t offset, size_t first_index, size_t n, double time, int seed);
+
+        ParticleEmitter emitter_;
+        ParticleForces forces_;
+        size_t count_;
+        std::vector<float> x_, y_, z_, zoom_, alpha_, rotation_;
+    };
+
+    namespace detail {
+        // 乱数の系統 (RandomFloatのframe引数に渡す)
+        enum ParticleStream :int {
+            kParticlePosX = 0, kParticlePosY, kParticlePosZ,
+            kParticleVelX, kParticleVelY, kParticleVelZ,
+            kParticleLife, kParticleRotation, kParticleSpin,
+            kParticleStreamNum
+        };
+    }
+}
+
+inline aut::ParticleSystem::ParticleSystem() : count_(0) {}
+
+inline void aut::ParticleSystem::SetEmitter(const ParticleEmitter &emitter) {
+    emitter_ = emitter;
+}
+
+inline void aut::ParticleSystem::SetForces(const ParticleForces &forces) {
+    forces_ = forces;
+}
+
+inline const aut::ParticleEmitter& aut::ParticleSystem::GetEmitter() const {
+    return emitter_;
+}
+
+inline const aut::ParticleForces& aut::ParticleSystem::GetForces() const {
+    return forces_;
+}
+
+inline size_t aut::ParticleSystem::Evaluate(double time, int seed, size_t max_count) {
+    count_ = 0;
+    const ParticleEmitter &e = emitter_;
+    double elapsed = time - e.start;
+    if (e.rate <= 0 || elapsed < 0 || max_count == 0)return 0;
+    double emitting = e.duration >= 0 ? std::min(elapsed, static_cast<double>(e.duration)) : elapsed;
+    double max_life = e.life + std::abs(e.life_spread);
+    // 発生済みで寿命内の可能性があるインデックスの範囲
+    size_t last = static_cast<size_t>(std::floor(emitting * e.rate));
+    double oldest = std::floor((elapsed - max_life) * e.rate);
+    size_t first = oldest > 0 ? static_cast<size_t>(oldest) : 0;
+    if (first > last)return 0;
+    first = std::max(first, last + 1 - std::min(last + 1, max_count));
+    size_t total = last + 1 - first;
+
+    size_t chunk_num = (total + kChunk - 1) / kChunk;
+    size_t capacity = chunk_num * kChunk;
+    for (auto *v : { &x_, &y_, &z_, &zoom_, &alpha_, &rotation_ })
+        if (v->size() < capacity)v->resize(capacity);
+    std::vector<size_t> alive(chunk_num);
+    ParallelFor(0, chunk_num, [&](size_t c) {
+        size_t n = std::min(kChunk, total - c * kChunk);
+        alive[c] = EvaluateChunk(c * kChunk, first + c * kChunk, n, time, seed);
+    });
+    // 各チャンクの生存分を前に詰める
+    for (size_t c = 0; c < chunk_num; c++) {
+        size_t src = c * kChunk;
+        if (src != count_) {
+            for (auto *v : { &x_, &y_, &z_, &zoom_, &alpha_, &rotation_ })
+                std::memmove(v->data() + count_, v->data() + src, alive[c] * sizeof(float));
+        }
+        count_ += alive[c];
+    }
+    return count_;
+}
+
+inline size_t aut::ParticleSystem::EvaluateChunk(size_t offset, size_t first_index, size_t n,
+                                                 double time, int seed) {
+    using namespace simd;
+    const ParticleEmitter &e = emitter_;
+    const ParticleForces &f = forces_;
+    // 乱数はkLanes単位で生成するので端数分も確保する
+    size_t padded = (n + kLanes - 1) / kLanes * kLanes;
+    float rnd[detail::kParticleStreamNum][kChunk];
+    float age[kChunk], decay[kChunk], life[kChunk];
+    for (int s = 0; s < detail::kParticleStreamNum; s++)
+        FillRandomFloat(rnd[s], padded, -1.f, 1.f, seed, s, static_cast<uint>(first_index));
+    for (size_t i = 0; i < padded; i++) {
+        double a = time - e.start - static_cast<double>(first_index + i) / e.rate;
+        age[i] = static_cast<float>(a);
+        decay[i] = f.drag > 0 ? static_cast<float>(std::exp(-f.drag * a)) : 0.f;
+    }
+
+    float *px = x_.data() + offset, *py = y_.data() + offset, *pz = z_.data() + offset;
+    float *pzoom = zoom_.data() + offset, *palpha = alpha_.data() + offset;
+    float *prot = rotation_.data() + offset;
+    float tail[6][kLanes];
+    // 終端速度 (dragが0の場合は使わない)
+    float inv_drag = f.drag > 0 ? 1 / f.drag : 0.f;
+    VFloat vinf_x = Set1(f.wind_x + f.gravity_x * inv_drag);
+    VFloat vinf_y = Set1(f.wind_y + f.gravity_y * inv_drag);
+    VFloat vinf_z = Set1(f.wind_z + f.gravity_z * inv_drag);
+    VFloat half_gx = Set1(f.gravity_x * 0.5f), half_gy = Set1(f.gravity_y * 0.5f);
+    VFloat half_gz = Set1(f.gravity_z * 0.5f);
+    VFloat one = Set1(1.f), zero = Set1(0.f);
+    for (size_t i = 0; i < padded; i += kLanes) {
+        VFloat t = Load(age + i);
+        VFloat l = Max(Set1(e.life) + Load(rnd[detail::kParticleLife] + i) * Set1(e.life_spread), Set1(1e-6f));
+        Store(life + i, l);
+        VFloat p0x = Set1(e.x) + Load(rnd[detail::kParticlePosX] + i) * Set1(e.range_x);
+        VFloat p0y = Set1(e.y) + Load(rnd[detail::kParticlePosY] + i) * Set1(e.range_y);
+        VFloat p0z = Set1(e.z) + Load(rnd[detail::kParticlePosZ] + i) * Set1(e.range_z);
+        VFloat v0x = Set1(e.vx) + Load(rnd[detail::kParticleVelX] + i) * Set1(e.speed_spread);
+        VFloat v0y = Set1(e.vy) + Load(rnd[detail::kParticleVelY] + i) * Set1(e.speed_spread);
+        VFloat v0z = Set1(e.vz) + Load(rnd[detail::kParticleVelZ] + i) * Set1(e.speed_spread);
+        VFloat x, y, z;
+        if (f.drag > 0) {
+            // dv/dt = g - drag * (v - wind) の解析解
+            VFloat k = (one - Load(decay + i)) * Set1(inv_drag);
+            x = p0x + vinf_x * t + (v0x - vinf_x) * k;
+            y = p0y + vinf_y * t + (v0y - vinf_y) * k;
+            z = p0z + vinf_z * t + (v0z - vinf_z) * k;
+        } else {
+            VFloat t2 = t * t;
+            x = p0x + v0x * t + half_gx * t2;
+            y = p0y + v0y * t + half_gy * t2;
+            z = p0z + v0z * t + half_gz * t2;
+        }
+        VFloat u = Min(Max(t / l, zero), one);
+        VFloat zm = Set1(e.zoom_begin) + Set1(e.zoom_end - e.zoom_begin) * u;
+        VFloat al = Set1(e.alpha_begin) + Set1(e.alpha_end - e.alpha_begin) * u;
+        VFloat rot = Load(rnd[detail::kParticleRotation] + i) * Set1(e.rotation_spread) +
+                     Load(rnd[detail::kParticleSpin] + i) * Set1(e.spin_spread) * t;
+        if (i + kLanes <= n) {
+            Store(px + i, x); Store(py + i, y); Store(pz + i, z);
+            Store(pzoom + i, zm); Store(palpha + i, al); Store(prot + i, rot);
+        } else {
+            // 最後の端数は一時領域を経由する
+            Store(tail[0], x); Store(tail[1], y); Store(tail[2], z);
+            Store(tail[3], zm); Store(tail[4], al); Store(tail[5], rot);
+            size_t m = n - i;
+            std::copy(tail[0], tail[0] + m, px + i); std::copy(tail[1], tail[1] + m, py + i);
+            std::copy(tail[2], tail[2] + m, pz + i); std::copy(tail[3], tail[3] + m, pzoom + i);
+            std::copy(tail[4], tail[4] + m, palpha + i); std::copy(tail[5], tail[5] + m, prot + i);
+        }
+    }
+    // 寿命内のものだけをチャンク内で前に詰める
+    size_t alive = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (age[i] < 0 || age[i] >= life[i])continue;
+        if (alive != i) {
+            px[alive] = px[i]; py[alive] = py[i]; pz[alive] = pz[i];
+            pzoom[alive] = pzoom[i]; palpha[alive] = palpha[i]; prot[alive] = prot[i];
+        }
+        alive++;
+    }
+    return alive;
+}
+
+inline size_t aut::ParticleSystem::Count() const {
+    return count_;
+}
+
+inline const float* aut::ParticleSystem::X() const {
+    return x_.data();
+}
+
+inline const float* aut::ParticleSystem::Y() const {
+    return y_.data();
+}
+
+inline const float* aut::ParticleSystem::Z() const {
+    return z_.data();
+}
+
+inline const float* aut::ParticleSystem::Zoom() const {
+    return zoom_.data();
+}
+
+inline const float* aut::ParticleSystem::Alpha() const {
+    return alpha_.data();
+}
+
+inline const float* aut::ParticleSystem::Rotation() const {
+    return rotation_.data();
+}
+
+inline void aut::ParticleSystem::Draw(lua_State *L) const {
+    GetAULFunc(L, "draw");
+    for (size_t i = 0; i < count_; i++) {
+        if (alpha_[i] <= 0)continue;
+        lua_pushvalue(L, -1);
+        size_t pushed_num = SetArgs(L, static_cast<double>(x_[i]), static_cast<double>(y_[i]),
+                                    static_cast<double>(z_[i]), static_cast<double>(zoom_[i]),
+                                    static_cast<double>(alpha_[i]), 0.0, 0.0, static_cast<double>(rotation_[i]));
+        lua_call(L, pushed_num, 0);
+    }
+    lua_pop(L, 2);
+}
+
+inline void aut::ParticleSystem::DrawPoly(lua_State *L, Size2D image_size) const {
+    const double kDegToRad = 3.14159265358979323846 / 180;
+    double w = image_size.w, h = image_size.h;
+    GetAULFunc(L, "drawpoly");
+    for (size_t i = 0; i < count_; i++) {
+        if (alpha_[i] <= 0)continue;
+        double hw = w * zoom_[i] * 0.5, hh = h * zoom_[i] * 0.5;
+        double c = std::cos(rotation_[i] * kDegToRad), s = std::sin(rotation_[i] * kDegToRad);
+        // 画面に平行な矩形の角 (左上から時計回り)
+        double ax = -hw * c + hh * s, ay = -hw * s - hh * c;
+        double bx = hw * c + hh * s, by = hw * s - hh * c;
+        double cx = x_[i], cy = y_[i], cz = z_[i];
+        lua_pushvalue(L, -1);
+        size_t pushed_num = SetArgs(L, cx + ax, cy + ay, cz, cx + bx, cy + by, cz,
+                                    cx - ax, cy - ay, cz, cx - bx, cy - by, cz,
+                                    0.0, 0.0, w, 0.0, w, h, 0.0, h, static_cast<double>(alpha_[i]));
+        lua_call(L, pushed_num, 0);
+    }
+    lua_pop(L, 2);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_PARTICLES_H_
@@ -0,0 +1,269 @@
+/**
+ * @file AUL_PixelBuffer.h
+ * @author SEED264
+ * @brief Region access to the pixel data with dirty tracking
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_PIXELBUFFER_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_PIXELBUFFER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <lua.hpp>
+#include "./AUL_Hash.h"
+#include "./AUL_Type.h"
+#include "./AUL_Wrapper.h"
+
+namespace aut {
+    /**
+     * Pixel data of obj.getpixeldata with rectangular read/write
+     *
+     * Writes are tracked per tile. A tile is hashed before its first write,
+     * and Commit calls obj.putpixeldata only when the hash of some written
+     * tile has changed. So the cost of small edits is proportional to the
+     * edited area, not to the size of the whole image.
+     */
+    class PixelBuffer {
+    public:
+        static constexpr unsigned int kTileSize = 64;
+
+        PixelBuffer();
+
+        /**
+         * Call obj.getpixeldata and attach the result
+         *
+         * @param[in] params Similar to obj.getpixeldata
+         */
+        template<typename... Params>
+        void Acquire(lua_State *L, Params&&... params);
+        /**
+         * Attach pixel data acquired elsewhere
+         *
+         * @param[in] data Pixel data
+         * @param[in] size Image size
+         */
+        void Attach(PixelRGBA *data, Size2D size);
+
+        PixelRGBA* Data();
+        Size2D GetSize() const;
+
+        /**
+         * Get a pixel
+         *
+         * @param[in] x,y Coords of the pixel (must be inside the image)
+         */
+        PixelRGBA GetPixel(int x, int y) const;
+        /**
+         * Put a pixel
+         *
+         * @param[in] x,y Coords of the pixel (ignored if outside the image)
+         * @param[in] pix Pixel data to put
+         */
+        void PutPixel(int x, int y, PixelRGBA pix);
+        /**
+         * Copy a rectangle of the image to out
+         * Pixels of out outside the image are left unchanged.
+         *
+         * @param[in] rect Rectangle to read
+         * @param[out] out Destination (rect.w * rect.h, packed)
+         */
+        void ReadRegion(Rect2D rect, PixelRGBA *out) const;
+        /**
+         * Copy src into a rectangle of the image
+         * Pixels outside the image are ignored.
+         *
+         * @param[in] rect Rectangle to write
+         * @param[in] src Source (rect.w * rect.h, packed)
+         */
+        void WriteRegion(Rect2D rect, const PixelRGBA *src);
+        /**
+         * Declare that a rectangle will be written through Data()
+         * Must be called before writing, because unchanged tiles are detected
+         * by the hash taken here.
+         *
+         * @param[in] rect Rectangle to be written
+         */
+        void Touch(Rect2D rect);
+        /**
+         * Get the tiles whose content differs from when they were first touched
+         * Horizontally adjacent tiles are merged into one rectangle.
+         *
+         * @return std::vector<Rect2D> Changed rectangles (clipped to the image)
+         */
+        std::vector<Rect2D> GetDirtyRects() const;
+        /**
+         * Call obj.putpixeldata if something has changed
+         *
+         * @return bool true = committed / false = nothing changed
+         */
+        bool Commit(lua_State *L);
+
+    private:
+        bool ClipRect(Rect2D *rect) const;
+        Rect2D TileRect(unsigned int tx, unsigned int ty) const;
+        bool IsTileChanged(size_t tile) const;
+
+        PixelRGBA *data_;
+        Size2D size_;
+        unsigned int tile_w_, tile_h_;
+        std::vector<unsigned long long> tile_hash_;
+        std::vector<byte> tile_touched_;
+    };
+}
+
+inline aut::PixelBuffer::PixelBuffer() : data_(nullptr), size_(), tile_w_(0), tile_h_(0) {}
+
+template<typename... Params>
+inline void aut::PixelBuffer::Acquire(lua_State *L, Params&&... params) {
+    PixelRGBA *data;
+    Size2D size;
+    getpixeldata(L, &data, &size, std::forward<Params>(params)...);
+    Attach(data, size);
+}
+
+inline void aut::PixelBuffer::Attach(PixelRGBA *data, Size2D size) {
+    data_ = data;
+    size_ = size;
+    tile_w_ = (size.w + kTileSize - 1) / kTileSize;
+    tile_h_ = (size.h + kTileSize - 1) / kTileSize;
+    tile_hash_.assign(tile_w_ * tile_h_, 0);
+    tile_touched_.assign(tile_w_ * tile_h_, 0);
+}
+
+inline aut::PixelRGBA* aut::PixelBuffer::Data() {
+    return data_;
+}
+
+inline aut::Size2D aut::PixelBuffer::GetSize() const {
+    return size_;
+}
+
+inline aut::PixelRGBA aut::PixelBuffer::GetPixel(int x, int y) const {
+    return data_[static_cast<size_t>(y) * size_.w + x];
+}
+
+inline void aut::PixelBuffer::PutPixel(int x, int y, PixelRGBA pix) {
+    if (x < 0 || y < 0 || x >= static_cast<int>(size_.w) || y >= static_cast<int>(size_.h))
+        return;
+    Touch(Rect2D(x, y, 1, 1));
+    data_[static_cast<size_t>(y) * size_.w + x] = pix;
+}
+
+inline void aut::PixelBuffer::ReadRegion(Rect2D rect, PixelRGBA *out) const {
+    Rect2D clipped = rect;
+    if (!ClipRect(&clipped))return;
+    for (unsigned int y = 0; y < clipped.h; y++) {
+        const PixelRGBA *src = data_ + static_cast<size_t>(clipped.y + y) * size_.w + clipped.x;
+        PixelRGBA *dst = out + static_cast<size_t>(clipped.y - rect.y + y) * rect.w + (clipped.x - rect.x);
+        std::copy(src, src + clipped.w, dst);
+    }
+}
+
+inline void aut::PixelBuffer::WriteRegion(Rect2D rect, const PixelRGBA *src) {
+    Rect2D clipped = rect;
+    if (!ClipRect(&clipped))return;
+    Touch(clipped);
+    for (unsigned int y = 0; y < clipped.h; y++) {
+        const PixelRGBA *s = src + static_cast<size_t>(clipped.y - rect.y + y) * rect.w + (clipped.x - rect.x);
+        std::copy(s, s + clipped.w, data_ + static_cast<size_t>(clipped.y + y) * size_.w + clipped.x);
+    }
+}
+
+inline void aut::PixelBuffer::Touch(Rect2D rect) {
+    if (!ClipRect(&rect))return;
+    unsigned int tx0 = rect.x / kTileSize, tx1 = (rect.x + rect.w - 1) / kTileSize;
+    unsigned int ty0 = rect.y / kTileSize, ty1 = (rect.y + rect.h - 1) / kTileSize;
+    for (unsigned int ty = ty0; ty <= ty1; ty++) {
+        for (unsigned int tx = tx0; tx <= tx1; tx++) {
+            size_t tile = ty * tile_w_ + tx;
+            if (tile_touched_[tile])continue;
+            tile_hash_[tile] = HashPixels(data_, size_.w, TileRect(tx, ty));
+            tile_touched_[tile] = 1;
+        }
+    }
+}
+
+inline std::vector<aut::Rect2D> aut::PixelBuffer::GetDirtyRects() const {
+    std::vector<Rect2D> rects;
+    for (unsigned int ty = 0; ty < tile_h_; ty++) {
+        bool open = false;
+        for (unsigned int tx = 0; tx < tile_w_; tx++) {
+            if (!IsTileChanged(ty * tile_w_ + tx)) {
+                open = false;
+                continue;
+            }
+            Rect2D r = TileRect(tx, ty);
+            if (open) {
+                rects.back().w += r.w;
+            } else {
+                rects.push_back(r);
+                open = true;
+            }
+        }
+    }
+    return rects;
+}
+
+inline bool aut::PixelBuffer::Commit(lua_State *L) {
+    bool changed = false;
+    for (size_t tile = 0; tile < tile_touched_.size() && !changed; tile++) {
+        changed = IsTileChanged(tile);
+    }
+    if (changed)
+        putpixeldata(L, data_);
+    std::fill(tile_touched_.begin(), tile_touched_.end(), 0);
+    return changed;
+}
+
+inline bool aut::PixelBuffer::ClipRect(Rect2D *rect) const {
+    long long x0 = std::max<long long>(rect->x, 0);
+    long long y0 = std::max<long long>(rect->y, 0);
+    long long x1 = std::min<long long>(static_cast<long long>(rect->x) + rect->w, size_.w);
+    long long y1 = std::min<long long>(static_cast<long long>(rect->y) + rect->h, size_.h);
+    if (x1 <= x0 || y1 <= y0)return false;
+    *rect = Rect2D(static_cast<int>(x0), static_cast<int>(y0),
+                   static_cast<unsigned int>(x1 - x0), static_cast<unsigned int>(y1 - y0));
+    return true;
+}
+
+inline aut::Rect2D aut::PixelBuffer::TileRect(unsigned int tx, unsigned int ty) const {
+    unsigned int x = tx * kTileSize, y = ty * kTileSize;
+    return Rect2D(x, y, std::min(kTileSize, size_.w - x), std::min(kTileSize, size_.h - y));
+}
+
+inline bool aut::PixelBuffer::IsTileChanged(size_t tile) const {
+    if (!tile_touched_[tile])return false;
+    unsigned int tx = static_cast<unsigned int>(tile % tile_w_);
+    unsigned int ty = static_cast<unsigned int>(tile / tile_w_);
+    return HashPixels(data_, size_.w, TileRect(tx, ty)) != tile_hash_[tile];
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_PIXELBUFFER_H_
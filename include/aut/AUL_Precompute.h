@@ -0,0 +1,277 @@
+/**
+ * @file AUL_Precompute.h
+ * @author SEED264
+ * @brief Speculative per-frame precomputation
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_PRECOMPUTE_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_PRECOMPUTE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "./AUL_Hash.h"
+
+namespace aut {
+    /**
+     * Cache of per-frame results with speculative computation of the next frame
+     * A job is a pure function of the frame number and of inputs captured on
+     * the Lua thread (describe them with inputs_hash, e.g. HashValues). While
+     * frame N renders, Prefetch(N + 1, ...) runs the job on a worker thread,
+     * and Get(N + 1, ...) picks up the result or waits for it. A request that
+     * does not match the running job (seek, changed parameters) cancels it.
+     *
+     * Jobs run off the Lua thread, so they must not touch lua_State and must
+     * own copies of their inputs. Long jobs should poll the cancel flag.
+     * Worker threads are joined by Cancel() and the destructor; call Cancel()
+     * before the script DLL is unloaded if the instance outlives it.
+     */
+    template<typename Result>
+    class FramePrecompute {
+    public:
+        using Job = std::function<Result(int frame, const std::atomic<bool> &cancel)>;
+
+        /**
+         * @param[in] capacity Maximum number of cached results
+         */
+        explicit FramePrecompute(size_t capacity = 4);
+        ~FramePrecompute();
+        FramePrecompute(const FramePrecompute&) = delete;
+        FramePrecompute& operator=(const FramePrecompute&) = delete;
+
+        /**
+         * Get the result of job for frame
+         * Returns the cached result if one matches, waits for the running
+         * job if it computes the same frame and inputs, and otherwise runs
+         * job on the calling thread.
+         *
+         * @param[in] frame Frame number
+         * @param[in] inputs_hash Hash of the inputs captured by job
+         * @param[in] job Function computing the result
+         *
+         * @return std::shared_ptr<const Result> Result (stays valid after eviction)
+         */
+        std::shared_ptr<const Result> Get(int frame, unsigned long long inputs_hash, const Job &job);
+        /**
+         * Start computing frame on a worker thread
+         * Does nothing if the result is cached or already being computed.
+         *
+         * @param[in] frame Frame number (usually the current frame + 1)
+         * @param[in] inputs_hash Hash of the inputs captured by job
+         * @param[in] job Function computing the result
+         */
+        void Prefetch(int frame, unsigned long long inputs_hash, Job job);
+        /**
+         * Find a cached result without computing anything
+         *
+         * @return std::shared_ptr<const Result> Result, or nullptr if not cached
+         */
+        std::shared_ptr<const Result> Find(int frame, unsigned long long inputs_hash);
+        /**
+         * Cancel the running jobs and wait for their threads
+         */
+        void Cancel();
+        /**
+         * Cancel the running jobs and drop all cached results
+         */
+        void Clear();
+
+    private:
+        struct Entry {
+            int frame;
+            unsigned long long hash;
+            std::shared_ptr<const Result> result;
+            unsigned long long last_use;
+        };
+        struct Task {
+            int frame;
+            unsigned long long hash;
+            std::atomic<bool> cancel;
+            std::atomic<bool> done;
+            std::thread thread;
+        };
+
+        std::shared_ptr<const Result> FindLocked(int frame, unsigned long long hash);
+        void Insert(int frame, unsigned long long hash, std::shared_ptr<const Result> result);
+        void RetireLocked();
+        void ReapRetired(bool wait);
+
+        std::mutex mutex_;
+        size_t capacity_;
+        unsigned long long use_count_;
+        std::vector<Entry> entries_;
+        // 実行中の先読み (最大1つ)
+        std::unique_ptr<Task> running_;
+        // 取り消し済みで終了待ちのスレッド
+        std::vector<std::unique_ptr<Task>> retired_;
+    };
+}
+
+template<typename Result>
+inline aut::FramePrecompute<Result>::FramePrecompute(size_t capacity)
+    : capacity_(std::max(capacity, static_cast<size_t>(1))), use_count_(0) {}
+
+template<typename Result>
+inline aut::FramePrecompute<Result>::~FramePrecompute() {
+    Cancel();
+}
+
+template<typename Result>
+inline std::shared_ptr<const Result> aut::FramePrecompute<Result>::Get(int frame, unsigned long long inputs_hash,
+                                                                       const Job &job) {
+    ReapRetired(false);
+    std::unique_ptr<Task> wait;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto result = FindLocked(frame, inputs_hash);
+        if (result)return result;
+        if (running_ && running_->frame == frame && running_->hash == inputs_hash)
+            wait = std::move(running_);
+        else
+            RetireLocked();
+    }
+    if (wait) {
+        // 先読みが同じフレームを計算中なので完了を待つ
+        wait->thread.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto result = FindLocked(frame, inputs_hash);
+        if (result)return result;
+    }
+    std::atomic<bool> cancel(false);
+    auto result = std::make_shared<const Result>(job(frame, cancel));
+    Insert(frame, inputs_hash, result);
+    return result;
+}
+
+template<typename Result>
+inline void aut::FramePrecompute<Result>::Prefetch(int frame, unsigned long long inputs_hash, Job job) {
+    ReapRetired(false);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_ && running_->frame == frame && running_->hash == inputs_hash)return;
+    RetireLocked();
+    for (const auto &e : entries_)
+        if (e.frame == frame && e.hash == inputs_hash)return;
+    running_.reset(new Task());
+    Task *task = running_.get();
+    task->frame = frame;
+    task->hash = inputs_hash;
+    task->cancel = false;
+    task->done = false;
+    task->thread = std::thread([this, task, job = std::move(job)]() {
+        Result result = job(task->frame, task->cancel);
+        // 取り消された結果は入力が古い可能性があるので捨てる
+        if (!task->cancel.load())
+            Insert(task->frame, task->hash, std::make_shared<const Result>(std::move(result)));
+        task->done = true;
+    });
+}
+
+template<typename Result>
+inline std::shared_ptr<const Result> aut::FramePrecompute<Result>::Find(int frame, unsigned long long inputs_hash) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return FindLocked(frame, inputs_hash);
+}
+
+template<typename Result>
+inline void aut::FramePrecompute<Result>::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        RetireLocked();
+    }
+    ReapRetired(true);
+}
+
+template<typename Result>
+inline void aut::FramePrecompute<Result>::Clear() {
+    Cancel();
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+template<typename Result>
+inline std::shared_ptr<const Result> aut::FramePrecompute<Result>::FindLocked(int frame,
+                                                                              unsigned long long hash) {
+    for (auto &e : entries_) {
+        if (e.frame == frame && e.hash == hash) {
+            e.last_use = ++use_count_;
+            return e.result;
+        }
+    }
+    return nullptr;
+}
+
+template<typename Result>
+inline void aut::FramePrecompute<Result>::Insert(int frame, unsigned long long hash,
+                                                 std::shared_ptr<const Result> result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &e : entries_) {
+        if (e.frame == frame && e.hash == hash) {
+            e.result = std::move(result);
+            e.last_use = ++use_count_;
+            return;
+        }
+    }
+    if (entries_.size() >= capacity_) {
+        auto oldest = entries_.begin();
+        for (auto e = entries_.begin(); e != entries_.end(); ++e)
+            if (e->last_use < oldest->last_use)oldest = e;
+        entries_.erase(oldest);
+    }
+    entries_.push_back(Entry{ frame, hash, std::move(result), ++use_count_ });
+}
+
+template<typename Result>
+inline void aut::FramePrecompute<Result>::RetireLocked() {
+    if (!running_)return;
+    running_->cancel = true;
+    retired_.push_back(std::move(running_));
+}
+
+template<typename Result>
+inline void aut::FramePrecompute<Result>::ReapRetired(bool wait) {
+    // joinはロックの外で行う (ワーカーは終了時にInsertでロックを取る)
+    std::vector<std::unique_ptr<Task>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = retired_.begin(); it != retired_.end();) {
+            if (wait || (*it)->done.load()) {
+                finished.push_back(std::move(*it));
+                it = retired_.erase(it);
+            }
+            else ++it;
+        }
+    }
+    for (auto &task : finished) task->thread.join();
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_PRECOMPUTE_H_
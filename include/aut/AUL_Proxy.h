@@ -0,0 +1,299 @@
+/**
+ * @file AUL_Proxy.h
+ * @author SEED264
+ * @brief Reduced resolution processing during preview
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_PROXY_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_PROXY_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <lua.hpp>
+#include "./AUL_Enum.h"
+#include "./AUL_ImagePool.h"
+#include "./AUL_Parallel.h"
+#include "./AUL_Type.h"
+#include "./AUL_Wrapper.h"
+
+namespace aut {
+    /**
+     * Get the quality used while not saving
+     *
+     * @return ProxyQuality Preview quality (kAutQualityHalf by default)
+     */
+    ProxyQuality GetPreviewQuality();
+    /**
+     * Set the quality used while not saving
+     *
+     * @param[in] quality Preview quality (kAutQualityFull disables proxies)
+     */
+    void SetPreviewQuality(ProxyQuality quality);
+    /**
+     * Get the quality for the current frame
+     * Always kAutQualityFull while saving (obj.getinfo("saving")).
+     *
+     * @return ProxyQuality Quality to process with
+     */
+    ProxyQuality GetQualityTier(lua_State *L);
+    /**
+     * Get the reduction factor of a quality
+     *
+     * @return int 1, 2 or 4
+     */
+    int ProxyFactor(ProxyQuality quality);
+    /**
+     * Get the size of the proxy of an image (rounded up)
+     */
+    Size2D ProxySize(Size2D size, ProxyQuality quality);
+    /**
+     * Reduce src to its proxy by averaging factor x factor blocks
+     * Colors are weighted by alpha so transparent pixels do not darken edges.
+     *
+     * @param[out] dst Destination (ProxySize(size, quality), packed)
+     * @param[in] src Source pixels (packed)
+     * @param[in] size Source size
+     * @param[in] quality Proxy quality
+     */
+    void ProxyDownscale(PixelRGBA *dst, const PixelRGBA *src, Size2D size, ProxyQuality quality);
+    /**
+     * Enlarge a proxy back to full resolution with bilinear filtering
+     *
+     * @param[out] dst Destination (size, packed)
+     * @param[in] size Full resolution size
+     * @param[in] src Proxy pixels (ProxySize(size, quality), packed)
+     * @param[in] quality Proxy quality
+     */
+    void ProxyUpscale(PixelRGBA *dst, Size2D size, const PixelRGBA *src, ProxyQuality quality);
+
+    /**
+     * Pixel data processed at the resolution of the current quality tier
+     *
+     * Begin takes the host buffer (e.g. of obj.getpixeldata) and, below
+     * full quality, reduces it into a pooled proxy. The pipeline then works
+     * on Data() / GetSize() with lengths converted by Scale(), and Resolve
+     * enlarges the result back into the host buffer. At full quality Data()
+     * is the host buffer itself, so both paths are the same code.
+     */
+    class ProxyImage {
+    public:
+        ProxyImage();
+
+        /**
+         * Attach a host buffer at the quality of GetQualityTier(L)
+         *
+         * @param[in,out] data Host pixel data
+         * @param[in] size Image size
+         */
+        void Begin(lua_State *L, PixelRGBA *data, Size2D size);
+        /**
+         * Attach a host buffer at the given quality
+         * Falls back to full quality if the pool can not provide the proxy.
+         */
+        void Begin(PixelRGBA *data, Size2D size, ProxyQuality quality);
+        /**
+         * Write the processed image back to the host buffer
+         */
+        void Resolve();
+
+        PixelRGBA* Data();
+        Size2D GetSize() const;
+        ProxyQuality Quality() const;
+        int Factor() const;
+        /**
+         * Convert a length (radius, offset, ...) or a coord with pixel edges
+         * at integers from full resolution pixels to proxy pixels
+         */
+        double Scale(double length) const;
+
+    private:
+        PixelRGBA *host_;
+        Size2D host_size_;
+        ProxyQuality quality_;
+        ScratchImage proxy_;
+    };
+
+    namespace detail {
+        inline std::atomic<int>& PreviewQualitySetting() {
+            static std::atomic<int> quality(kAutQualityHalf);
+            return quality;
+        }
+    }
+}
+
+inline aut::ProxyQuality aut::GetPreviewQuality() {
+    return static_cast<ProxyQuality>(detail::PreviewQualitySetting().load());
+}
+
+inline void aut::SetPreviewQuality(ProxyQuality quality) {
+    detail::PreviewQualitySetting().store(quality);
+}
+
+inline aut::ProxyQuality aut::GetQualityTier(lua_State *L) {
+    return getinfo_saving(L) ? kAutQualityFull : GetPreviewQuality();
+}
+
+inline int aut::ProxyFactor(ProxyQuality quality) {
+    switch (quality) {
+    case kAutQualityHalf:
+        return 2;
+    case kAutQualityQuarter:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+inline aut::Size2D aut::ProxySize(Size2D size, ProxyQuality quality) {
+    unsigned int f = ProxyFactor(quality);
+    return Size2D((size.w + f - 1) / f, (size.h + f - 1) / f);
+}
+
+inline void aut::ProxyDownscale(PixelRGBA *dst, const PixelRGBA *src, Size2D size, ProxyQuality quality) {
+    unsigned int f = ProxyFactor(quality);
+    Size2D ps = ProxySize(size, quality);
+    ParallelFor(0, ps.h, [&](size_t py) {
+        unsigned int y0 = static_cast<unsigned int>(py) * f, y1 = std::min(y0 + f, size.h);
+        PixelRGBA *out = dst + py * ps.w;
+        for (unsigned int px = 0; px < ps.w; px++) {
+            unsigned int x0 = px * f, x1 = std::min(x0 + f, size.w);
+            unsigned int sr = 0, sg = 0, sb = 0, sa = 0;
+            for (unsigned int y = y0; y < y1; y++) {
+                const PixelRGBA *row = src + static_cast<size_t>(y) * size.w;
+                for (unsigned int x = x0; x < x1; x++) {
+                    unsigned int a = row[x].a;
+                    sr += row[x].r * a;
+                    sg += row[x].g * a;
+                    sb += row[x].b * a;
+                    sa += a;
+                }
+            }
+            unsigned int n = (y1 - y0) * (x1 - x0);
+            if (sa == 0) {
+                out[px] = PixelRGBA();
+                continue;
+            }
+            out[px] = PixelRGBA(static_cast<byte>((sr + sa / 2) / sa), static_cast<byte>((sg + sa / 2) / sa),
+                                static_cast<byte>((sb + sa / 2) / sa), static_cast<byte>((sa + n / 2) / n));
+        }
+    }, 4);
+}
+
+inline void aut::ProxyUpscale(PixelRGBA *dst, Size2D size, const PixelRGBA *src, ProxyQuality quality) {
+    int f = ProxyFactor(quality);
+    Size2D ps = ProxySize(size, quality);
+    // 倍率が整数なので重みはf通りしかない (位相ごとに前計算する)
+    float phase_w[4];
+    int phase_o[4];
+    for (int k = 0; k < f; k++) {
+        float s = (k + 0.5f) / f - 0.5f;
+        phase_o[k] = s < 0 ? -1 : 0;
+        phase_w[k] = s - phase_o[k];
+    }
+    auto tap = [](int i, unsigned int n) {
+        return static_cast<unsigned int>(std::min(std::max(i, 0), static_cast<int>(n) - 1));
+    };
+    ParallelFor(0, size.h, [&](size_t y) {
+        int py = static_cast<int>(y) / f, ky = static_cast<int>(y) % f;
+        float wy = phase_w[ky];
+        const PixelRGBA *row0 = src + tap(py + phase_o[ky], ps.h) * static_cast<size_t>(ps.w);
+        const PixelRGBA *row1 = src + tap(py + phase_o[ky] + 1, ps.h) * static_cast<size_t>(ps.w);
+        PixelRGBA *out = dst + y * size.w;
+        for (unsigned int x = 0; x < size.w; x++) {
+            int px = static_cast<int>(x) / f, kx = static_cast<int>(x) % f;
+            float wx = phase_w[kx];
+            unsigned int x0 = tap(px + phase_o[kx], ps.w), x1 = tap(px + phase_o[kx] + 1, ps.w);
+            const PixelRGBA *p[4] = { row0 + x0, row0 + x1, row1 + x0, row1 + x1 };
+            float w[4] = { (1 - wx) * (1 - wy), wx * (1 - wy), (1 - wx) * wy, wx * wy };
+            float r = 0, g = 0, b = 0, a = 0;
+            for (int i = 0; i < 4; i++) {
+                float m = w[i] * p[i]->a;
+                r += p[i]->r * m;
+                g += p[i]->g * m;
+                b += p[i]->b * m;
+                a += m;
+            }
+            if (a <= 0) {
+                out[x] = PixelRGBA();
+                continue;
+            }
+            float inv = 1 / a;
+            out[x] = PixelRGBA(static_cast<byte>(r * inv + 0.5f), static_cast<byte>(g * inv + 0.5f),
+                               static_cast<byte>(b * inv + 0.5f), static_cast<byte>(a + 0.5f));
+        }
+    }, 4);
+}
+
+inline aut::ProxyImage::ProxyImage() : host_(nullptr), host_size_(), quality_(kAutQualityFull) {}
+
+inline void aut::ProxyImage::Begin(lua_State *L, PixelRGBA *data, Size2D size) {
+    Begin(data, size, GetQualityTier(L));
+}
+
+inline void aut::ProxyImage::Begin(PixelRGBA *data, Size2D size, ProxyQuality quality) {
+    host_ = data;
+    host_size_ = size;
+    quality_ = kAutQualityFull;
+    proxy_.Release();
+    if (quality == kAutQualityFull || size.w == 0 || size.h == 0)return;
+    Size2D ps = ProxySize(size, quality);
+    // パディングなしで使えるように1行の画像として借りる
+    proxy_ = ImagePool::Default().Get(Size2D(ps.w * ps.h, 1));
+    if (!proxy_.IsValid())return;
+    quality_ = quality;
+    ProxyDownscale(proxy_.Data(), host_, size, quality);
+}
+
+inline void aut::ProxyImage::Resolve() {
+    if (quality_ == kAutQualityFull || !host_)return;
+    ProxyUpscale(host_, host_size_, proxy_.Data(), quality_);
+}
+
+inline aut::PixelRGBA* aut::ProxyImage::Data() {
+    return quality_ == kAutQualityFull ? host_ : proxy_.Data();
+}
+
+inline aut::Size2D aut::ProxyImage::GetSize() const {
+    return ProxySize(host_size_, quality_);
+}
+
+inline aut::ProxyQuality aut::ProxyImage::Quality() const {
+    return quality_;
+}
+
+inline int aut::ProxyImage::Factor() const {
+    return ProxyFactor(quality_);
+}
+
+inline double aut::ProxyImage::Scale(double length) const {
+    return length / Factor();
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_PROXY_H_
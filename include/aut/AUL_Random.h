@@ -0,0 +1,273 @@
+/**
+ * @file AUL_Random.h
+ * @author SEED264
+ * @brief Stateless counter-based random number generator
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_RANDOM_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_RANDOM_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <lua.hpp>
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+#include "./AUL_Wrapper.h"
+
+namespace aut {
+    /**
+     * Generate 32 random bits
+     * The result depends only on (seed, frame, index), so it can be computed
+     * on any thread and in any order (Philox4x32-10).
+     *
+     * @param[in] seed Random seed (Similar to the seed of obj.rand)
+     * @param[in] frame Frame number to mix into the key
+     * @param[in] index Index of the value in the sequence
+     *
+     * @return uint Random bits
+     */
+    uint RandomBits(int seed, int frame, uint index);
+    /**
+     * Generate a random integer in [st_num, ed_num]
+     * Only 32 random bits are drawn, so a range wider than 2^32 values is
+     * clamped to [st_num, st_num + 2^32 - 1].
+     *
+     * @param[in] st_num Minimum random number
+     * @param[in] ed_num Maximum random number
+     * @param[in] seed Random seed
+     * @param[in] frame Frame number to mix into the key
+     * @param[in] index Index of the value in the sequence
+     *
+     * @return lua_Integer Generated random number
+     */
+    lua_Integer RandomInteger(lua_Integer st_num, lua_Integer ed_num,
+                              int seed, int frame, uint index);
+    /**
+     * Generate a random number in [st_num, ed_num)
+     *
+     * @param[in] st_num Minimum random number
+     * @param[in] ed_num Maximum random number
+     * @param[in] seed Random seed
+     * @param[in] frame Frame number to mix into the key
+     * @param[in] index Index of the value in the sequence
+     *
+     * @return float Generated random number
+     */
+    float RandomFloat(float st_num, float ed_num, int seed, int frame, uint index);
+    /**
+     * Fill an array with random bits
+     * out[i] is equal to RandomBits(seed, frame, first_index + i).
+     *
+     * @param[out] out Destination array
+     * @param[in] count Number of values to generate
+     * @param[in] seed Random seed
+     * @param[in] frame Frame number to mix into the key
+     * @param[in] first_index Index of out[0]
+     */
+    void FillRandomBits(uint *out, size_t count, int seed, int frame, uint first_index = 0);
+    /**
+     * Fill an array with random integers in [st_num, ed_num]
+     * out[i] is equal to RandomInteger(st_num, ed_num, seed, frame, first_index + i).
+     *
+     * @param[out] out Destination array
+     * @param[in] count Number of values to generate
+     * @param[in] st_num Minimum random number
+     * @param[in] ed_num Maximum random number
+     * @param[in] seed Random seed
+     * @param[in] frame Frame number to mix into the key
+     * @param[in] first_index Index of out[0]
+     */
+    void FillRandomInteger(lua_Integer *out, size_t count,
+                           lua_Integer st_num, lua_Integer ed_num,
+                           int seed, int frame, uint first_index = 0);
+    /**
+     * Fill an array with random numbers in [st_num, ed_num)
+     * out[i] is equal to RandomFloat(st_num, ed_num, seed, frame, first_index + i).
+     *
+     * @param[out] out Destination array
+     * @param[in] count Number of values to generate
+     * @param[in] st_num Minimum random number
+     * @param[in] ed_num Maximum random number
+     * @param[in] seed Random seed
+     * @param[in] frame Frame number to mix into the key
+     * @param[in] first_index Index of out[0]
+     */
+    void FillRandomFloat(float *out, size_t count, float st_num, float ed_num,
+                         int seed, int frame, uint first_index = 0);
+    /**
+     * Fill an array with values of obj.rand
+     * The values are exactly what obj.rand returns, because obj.rand itself is
+     * called. obj.rand is looked up only once for the whole array.
+     * out[i] is equal to aut::rand(L, st_num, ed_num, seed + i * seed_step, frame).
+     *
+     * @param[out] out Destination array
+     * @param[in] count Number of values to generate
+     * @param[in] st_num Minimum random number
+     * @param[in] ed_num Maximum random number
+     * @param[in] seed Seed of out[0]
+     * @param[in] frame Frame number (Similar to obj.rand)
+     * @param[in] seed_step Difference of the seed between adjacent elements
+     */
+    void FillHostRandom(lua_State *L, lua_Integer *out, size_t count,
+                        lua_Integer st_num, lua_Integer ed_num,
+                        lua_Integer seed, lua_Integer frame, lua_Integer seed_step = 1);
+
+    namespace detail {
+        constexpr uint kPhiloxM0 = 0xD2511F53u;
+        constexpr uint kPhiloxM1 = 0xCD9E8D57u;
+        constexpr uint kPhiloxW0 = 0x9E3779B9u;
+        constexpr uint kPhiloxW1 = 0xBB67AE85u;
+        // 2番目の鍵はseedと独立した定数にしておく
+        constexpr uint kPhiloxKey1 = 0x5EED264Du;
+
+        void PhiloxBits(simd::VUInt index, uint seed, uint frame, simd::VUInt *out);
+        unsigned long long IntegerRange(lua_Integer st_num, lua_Integer ed_num);
+        lua_Integer ScaleBits(uint bits, lua_Integer st_num, unsigned long long range);
+    }
+}
+
+inline aut::uint aut::RandomBits(int seed, int frame, uint index) {
+    uint c0 = index, c1 = static_cast<uint>(frame), c2 = 0, c3 = 0;
+    uint k0 = static_cast<uint>(seed), k1 = detail::kPhiloxKey1;
+    for (int round = 0; round < 10; round++) {
+        unsigned long long p0 = static_cast<unsigned long long>(detail::kPhiloxM0) * c0;
+        unsigned long long p1 = static_cast<unsigned long long>(detail::kPhiloxM1) * c2;
+        uint hi0 = static_cast<uint>(p0 >> 32), lo0 = static_cast<uint>(p0);
+        uint hi1 = static_cast<uint>(p1 >> 32), lo1 = static_cast<uint>(p1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += detail::kPhiloxW0;
+        k1 += detail::kPhiloxW1;
+    }
+    return c0;
+}
+
+inline void aut::detail::PhiloxBits(simd::VUInt index, uint seed, uint frame, simd::VUInt *out) {
+    using namespace simd;
+    VUInt c0 = index, c1 = Set1(frame), c2 = Set1(0u), c3 = Set1(0u);
+    uint k0 = seed, k1 = kPhiloxKey1;
+    for (int round = 0; round < 10; round++) {
+        VUInt hi0, lo0, hi1, lo1;
+        MulWide(c0, kPhiloxM0, &hi0, &lo0);
+        MulWide(c2, kPhiloxM1, &hi1, &lo1);
+        c0 = hi1 ^ c1 ^ Set1(k0);
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ Set1(k1);
+        c3 = lo0;
+        k0 += kPhiloxW0;
+        k1 += kPhiloxW1;
+    }
+    *out = c0;
+}
+
+inline unsigned long long aut::detail::IntegerRange(lua_Integer st_num, lua_Integer ed_num) {
+    // 符号付きのままだと溢れるので符号なしで差を取る
+    // 32bitの乱数から取り出せる2^32通りを上限にする
+    unsigned long long span = static_cast<unsigned long long>(ed_num) - static_cast<unsigned long long>(st_num);
+    return span >= 0xFFFFFFFFull ? 0x100000000ull : span + 1;
+}
+
+inline lua_Integer aut::detail::ScaleBits(uint bits, lua_Integer st_num, unsigned long long range) {
+    // range <= 2^32 なので積は64bitに収まり、結果は[st_num, ed_num]に入る
+    unsigned long long offset = (static_cast<unsigned long long>(bits) * range) >> 32;
+    return static_cast<lua_Integer>(static_cast<unsigned long long>(st_num) + offset);
+}
+
+inline lua_Integer aut::RandomInteger(lua_Integer st_num, lua_Integer ed_num,
+                                      int seed, int frame, uint index) {
+    if (st_num > ed_num) std::swap(st_num, ed_num);
+    return detail::ScaleBits(RandomBits(seed, frame, index), st_num,
+                             detail::IntegerRange(st_num, ed_num));
+}
+
+inline float aut::RandomFloat(float st_num, float ed_num, int seed, int frame, uint index) {
+    float t = static_cast<float>(RandomBits(seed, frame, index) >> 8) * (1.f / 16777216.f);
+    return st_num + (ed_num - st_num) * t;
+}
+
+inline void aut::FillRandomBits(uint *out, size_t count, int seed, int frame, uint first_index) {
+    size_t i = 0;
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        simd::VUInt bits;
+        detail::PhiloxBits(simd::Iota(first_index + static_cast<uint>(i)),
+                           static_cast<uint>(seed), static_cast<uint>(frame), &bits);
+        simd::Store(out + i, bits);
+    }
+    for (; i < count; i++) {
+        out[i] = RandomBits(seed, frame, first_index + static_cast<uint>(i));
+    }
+}
+
+inline void aut::FillRandomInteger(lua_Integer *out, size_t count,
+                                   lua_Integer st_num, lua_Integer ed_num,
+                                   int seed, int frame, uint first_index) {
+    if (st_num > ed_num) std::swap(st_num, ed_num);
+    unsigned long long range = detail::IntegerRange(st_num, ed_num);
+    uint bits[simd::kLanes];
+    for (size_t i = 0; i < count; i += simd::kLanes) {
+        size_t n = std::min(simd::kLanes, count - i);
+        FillRandomBits(bits, n, seed, frame, first_index + static_cast<uint>(i));
+        for (size_t j = 0; j < n; j++) {
+            out[i + j] = detail::ScaleBits(bits[j], st_num, range);
+        }
+    }
+}
+
+inline void aut::FillRandomFloat(float *out, size_t count, float st_num, float ed_num,
+                                 int seed, int frame, uint first_index) {
+    const float scale = (ed_num - st_num) * (1.f / 16777216.f);
+    uint bits[simd::kLanes];
+    for (size_t i = 0; i < count; i += simd::kLanes) {
+        size_t n = std::min(simd::kLanes, count - i);
+        FillRandomBits(bits, n, seed, frame, first_index + static_cast<uint>(i));
+        for (size_t j = 0; j < n; j++) {
+            out[i + j] = st_num + static_cast<float>(bits[j] >> 8) * scale;
+        }
+    }
+}
+
+inline void aut::FillHostRandom(lua_State *L, lua_Integer *out, size_t count,
+                                lua_Integer st_num, lua_Integer ed_num,
+                                lua_Integer seed, lua_Integer frame, lua_Integer seed_step) {
+    GetAULFunc(L, "rand");
+    for (size_t i = 0; i < count; i++) {
+        lua_pushvalue(L, -1);
+        size_t pushed_num = SetArgs(L, st_num, ed_num,
+                                    seed + static_cast<lua_Integer>(i) * seed_step, frame);
+        lua_call(L, pushed_num, 1);
+        out[i] = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 2);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_RANDOM_H_
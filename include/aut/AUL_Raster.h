@@ -0,0 +1,366 @@
+/**
+ * @file AUL_Raster.h
+ * @author SEED264
+ * @brief Software rasterizer for textured triangles and quads
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_RASTER_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_RASTER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include <lua.hpp>
+#include "./AUL_Enum.h"
+#include "./AUL_ImagePool.h"
+#include "./AUL_Parallel.h"
+#include "./AUL_Sampling.h"
+#include "./AUL_Type.h"
+#include "./AUL_Wrapper.h"
+
+namespace aut {
+    // ラスタライザーの頂点
+    struct RasterVertex {
+        // 出力先のピクセル座標
+        float x, y;
+        // テクスチャのピクセル座標 (obj.drawpolyと同じく画素の端が整数)
+        float u, v;
+        // 不透明度
+        float alpha;
+        // 同次座標のw (0なら三角形は1、四角形は対角線から透視を推定する)
+        float w;
+
+        RasterVertex() : x(0), y(0), u(0), v(0), alpha(1), w(0) {}
+        RasterVertex(float ax, float ay, float au, float av, float aalpha = 1, float aw = 0)
+            : x(ax), y(ay), u(au), v(av), alpha(aalpha), w(aw) {}
+    };
+
+    /**
+     * Software rasterizer for batches of textured triangles and quads
+     *
+     * Primitives are binned into 64x64 tiles, and the tiles are rendered in
+     * parallel, each in submission order, so the result does not depend on
+     * the number of threads. UVs and alpha are interpolated perspective
+     * correctly. Outer edges are anti-aliased by the pixel distance to the
+     * edge function. The diagonal shared by the two halves of a quad uses
+     * the same coefficients in both and is split by sign, so no pixel on it
+     * is skipped or drawn twice. Results are composited over
+     * the destination with straight alpha.
+     */
+    class Rasterizer {
+    public:
+        static constexpr unsigned int kTileSize = 64;
+
+        Rasterizer();
+
+        /**
+         * Remove all primitives (the memory is kept for the next batch)
+         */
+        void Clear();
+        void AddTriangle(const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2);
+        /**
+         * Add a quad split along the v0-v2 diagonal
+         * Vertices are in order around the quad, like obj.drawpoly.
+         */
+        void AddQuad(const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2,
+                     const RasterVertex &v3);
+        size_t TriangleCount() const;
+
+        /**
+         * Render the batch over dst
+         *
+         * @param[in,out] dst Destination pixels (packed)
+         * @param[in] dst_size Destination size
+         * @param[in] texture Texture pixels (packed)
+         * @param[in] texture_size Texture size
+         * @param[in] address Addressing mode outside the texture
+         * @param[in] filter Filter mode
+         * @param[in] antialias Anti-alias the outer edges
+         */
+        void Render(PixelRGBA *dst, Size2D dst_size, const PixelRGBA *texture, Size2D texture_size,
+                    SamplingAddressMode address = kAutAddressBorder,
+                    SamplingFilterMode filter = kAutFilterLinear, bool antialias = true);
+        /**
+         * Replace the current object image with the batch textured by it
+         * Calls obj.getpixeldata and obj.putpixeldata once each. Enlarge the
+         * object beforehand if the primitives reach outside of it.
+         *
+         * @return bool false if no scratch image was available for the texture
+         */
+        bool RenderObject(lua_State *L, SamplingAddressMode address = kAutAddressBorder,
+                          SamplingFilterMode filter = kAutFilterLinear, bool antialias = true);
+
+    private:
+        // 三角形の前計算
+        struct Triangle {
+            // 値の絶対値が辺からのピクセル距離になる辺関数 (辺iは頂点iの対辺)
+            float ea[3], eb[3], ec[3];
+            // 辺関数に掛けると内側が正になる符号
+            // 四角形の対角線は両半分で同じ係数を使い、この符号だけが異なる
+            float side[3];
+            // 辺関数から重心座標への係数
+            float bary[3];
+            // 頂点属性 (q = 1/w、u*q、v*q、alpha*q)
+            float q[3], uq[3], vq[3], aq[3];
+            // 辺をアンチエイリアスするか (四角形の対角線はしない)
+            bool smooth[3];
+            // qが全頂点で等しい (透視補正の除算が要らない)
+            bool affine;
+            int x0, y0, x1, y1;
+        };
+
+        void AddTriangle(const RasterVertex (&v)[3], const float (&q)[3], int shared_edge = -1,
+                         const float *shared = nullptr);
+        void Bin(Size2D dst_size);
+        template<SamplingAddressMode Address, SamplingFilterMode Filter>
+        void RenderTile(PixelRGBA *dst, Size2D dst_size, const PixelRGBA *texture, Size2D texture_size,
+                        unsigned int tx, unsigned int ty, bool antialias) const;
+
+        std::vector<Triangle> triangles_;
+        unsigned int tiles_x_, tiles_y_;
+        std::vector<uint> bin_start_;
+        std::vector<uint> bin_triangles_;
+    };
+}
+
+inline aut::Rasterizer::Rasterizer() : tiles_x_(0), tiles_y_(0) {}
+
+inline void aut::Rasterizer::Clear() {
+    triangles_.clear();
+}
+
+inline size_t aut::Rasterizer::TriangleCount() const {
+    return triangles_.size();
+}
+
+inline void aut::Rasterizer::AddTriangle(const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2) {
+    const RasterVertex v[3] = { v0, v1, v2 };
+    float q[3];
+    for (int i = 0; i < 3; i++) q[i] = v[i].w > 0 ? 1 / v[i].w : 1.f;
+    AddTriangle(v, q);
+}
+
+inline void aut::Rasterizer::AddQuad(const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2,
+                                     const RasterVertex &v3) {
+    const RasterVertex v[4] = { v0, v1, v2, v3 };
+    float q[4] = { 1, 1, 1, 1 };
+    if (v0.w > 0 && v1.w > 0 && v2.w > 0 && v3.w > 0) {
+        for (int i = 0; i < 4; i++) q[i] = 1 / v[i].w;
+    } else {
+        // 対角線の交点までの距離の比から射影変換の重みを求める
+        float d1x = v2.x - v0.x, d1y = v2.y - v0.y, d2x = v3.x - v1.x, d2y = v3.y - v1.y;
+        float den = d1x * d2y - d1y * d2x;
+        if (std::abs(den) > 1e-12f) {
+            float s = ((v1.x - v0.x) * d2y - (v1.y - v0.y) * d2x) / den;
+            float t = ((v1.x - v0.x) * d1y - (v1.y - v0.y) * d1x) / den;
+            if (s > 0 && s < 1 && t > 0 && t < 1) {
+                float d[4] = { s, t, 1 - s, 1 - t };
+                for (int i = 0; i < 4; i++) q[i] = (d[i] + d[(i + 2) % 4]) / d[(i + 2) % 4];
+            }
+        }
+    }
+    // 対角線v0-v2の辺関数は1度だけ求めて両半分で共有する
+    // 同じ係数を同じ式で評価するので、境界上の画素もどちらか一方だけが塗る
+    float ea = -(v2.y - v0.y), eb = v2.x - v0.x;
+    float len = std::sqrt(ea * ea + eb * eb);
+    if (len <= 0)return;
+    const float diagonal[3] = { ea / len, eb / len, -(ea / len * v0.x + eb / len * v0.y) };
+    const RasterVertex a[3] = { v[0], v[1], v[2] }, b[3] = { v[0], v[2], v[3] };
+    const float qa[3] = { q[0], q[1], q[2] }, qb[3] = { q[0], q[2], q[3] };
+    AddTriangle(a, qa, 1, diagonal);
+    AddTriangle(b, qb, 2, diagonal);
+}
+
+inline void aut::Rasterizer::AddTriangle(const RasterVertex (&v)[3], const float (&q)[3], int shared_edge,
+                                         const float *shared) {
+    float area2 = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    if (std::abs(area2) < 1e-8f)return;
+    float sign = area2 > 0 ? 1.f : -1.f;
+    Triangle t;
+    for (int i = 0; i < 3; i++) {
+        const RasterVertex &a = v[(i + 1) % 3], &b = v[(i + 2) % 3];
+        float ea = -(b.y - a.y) * sign, eb = (b.x - a.x) * sign;
+        float len = std::sqrt(ea * ea + eb * eb);
+        if (len <= 0)return;
+        if (i == shared_edge) {
+            t.ea[i] = shared[0];
+            t.eb[i] = shared[1];
+            t.ec[i] = shared[2];
+            // 対辺の頂点がある側を内側にする
+            t.side[i] = shared[0] * v[i].x + shared[1] * v[i].y + shared[2] > 0 ? 1.f : -1.f;
+        } else {
+            t.ea[i] = ea / len;
+            t.eb[i] = eb / len;
+            t.ec[i] = -(t.ea[i] * a.x + t.eb[i] * a.y);
+            t.side[i] = 1;
+        }
+        t.bary[i] = len / std::abs(area2);
+        t.q[i] = q[i];
+        t.uq[i] = v[i].u * q[i];
+        t.vq[i] = v[i].v * q[i];
+        t.aq[i] = v[i].alpha * q[i];
+        t.smooth[i] = i != shared_edge;
+    }
+    t.affine = q[0] == q[1] && q[1] == q[2];
+    float min_x = std::min({ v[0].x, v[1].x, v[2].x }), max_x = std::max({ v[0].x, v[1].x, v[2].x });
+    float min_y = std::min({ v[0].y, v[1].y, v[2].y }), max_y = std::max({ v[0].y, v[1].y, v[2].y });
+    // アンチエイリアスで辺の外側0.5ピクセルまで塗るので広げておく
+    t.x0 = static_cast<int>(std::floor(min_x - 0.5f));
+    t.y0 = static_cast<int>(std::floor(min_y - 0.5f));
+    t.x1 = static_cast<int>(std::ceil(max_x + 0.5f));
+    t.y1 = static_cast<int>(std::ceil(max_y + 0.5f));
+    triangles_.push_back(t);
+}
+
+inline void aut::Rasterizer::Bin(Size2D dst_size) {
+    tiles_x_ = (dst_size.w + kTileSize - 1) / kTileSize;
+    tiles_y_ = (dst_size.h + kTileSize - 1) / kTileSize;
+    size_t tile_num = static_cast<size_t>(tiles_x_) * tiles_y_;
+    bin_start_.assign(tile_num + 1, 0);
+    auto tile_range = [&](const Triangle &t, int *tx0, int *ty0, int *tx1, int *ty1) {
+        *tx0 = std::max(t.x0, 0) / static_cast<int>(kTileSize);
+        *ty0 = std::max(t.y0, 0) / static_cast<int>(kTileSize);
+        *tx1 = std::min(t.x1, static_cast<int>(dst_size.w) - 1) / static_cast<int>(kTileSize);
+        *ty1 = std::min(t.y1, static_cast<int>(dst_size.h) - 1) / static_cast<int>(kTileSize);
+        return t.x1 >= 0 && t.y1 >= 0 && t.x0 < static_cast<int>(dst_size.w) && t.y0 < static_cast<int>(dst_size.h);
+    };
+    // 計数ソートでタイル毎の三角形を投入順に並べる
+    int tx0, ty0, tx1, ty1;
+    for (const auto &t : triangles_) {
+        if (!tile_range(t, &tx0, &ty0, &tx1, &ty1))continue;
+        for (int ty = ty0; ty <= ty1; ty++)
+            for (int tx = tx0; tx <= tx1; tx++) bin_start_[static_cast<size_t>(ty) * tiles_x_ + tx + 1]++;
+    }
+    for (size_t i = 0; i < tile_num; i++) bin_start_[i + 1] += bin_start_[i];
+    bin_triangles_.resize(bin_start_[tile_num]);
+    std::vector<uint> next(bin_start_.begin(), bin_start_.end() - 1);
+    for (size_t i = 0; i < triangles_.size(); i++) {
+        if (!tile_range(triangles_[i], &tx0, &ty0, &tx1, &ty1))continue;
+        for (int ty = ty0; ty <= ty1; ty++)
+            for (int tx = tx0; tx <= tx1; tx++)
+                bin_triangles_[next[static_cast<size_t>(ty) * tiles_x_ + tx]++] = static_cast<uint>(i);
+    }
+}
+
+inline void aut::Rasterizer::Render(PixelRGBA *dst, Size2D dst_size, const PixelRGBA *texture,
+                                    Size2D texture_size, SamplingAddressMode address, SamplingFilterMode filter,
+                                    bool antialias) {
+    if (triangles_.empty() || dst_size.w == 0 || dst_size.h == 0)return;
+    Bin(dst_size);
+    detail::DispatchSampling(address, filter, [&](auto a, auto f) {
+        ParallelFor(0, static_cast<size_t>(tiles_x_) * tiles_y_, [&](size_t tile) {
+            RenderTile<decltype(a)::value, decltype(f)::value>(
+                dst, dst_size, texture, texture_size, static_cast<unsigned int>(tile % tiles_x_),
+                static_cast<unsigned int>(tile / tiles_x_), antialias);
+        });
+    });
+}
+
+template<aut::SamplingAddressMode Address, aut::SamplingFilterMode Filter>
+inline void aut::Rasterizer::RenderTile(PixelRGBA *dst, Size2D dst_size, const PixelRGBA *texture,
+                                        Size2D texture_size, unsigned int tx, unsigned int ty,
+                                        bool antialias) const {
+    size_t tile = static_cast<size_t>(ty) * tiles_x_ + tx;
+    int tile_x0 = static_cast<int>(tx * kTileSize), tile_y0 = static_cast<int>(ty * kTileSize);
+    int tile_x1 = std::min(tile_x0 + static_cast<int>(kTileSize), static_cast<int>(dst_size.w)) - 1;
+    int tile_y1 = std::min(tile_y0 + static_cast<int>(kTileSize), static_cast<int>(dst_size.h)) - 1;
+    for (uint k = bin_start_[tile]; k < bin_start_[tile + 1]; k++) {
+        // 書き込み先とのエイリアスを避けるためにコピーして使う
+        const Triangle t = triangles_[bin_triangles_[k]];
+        int x0 = std::max(t.x0, tile_x0), x1 = std::min(t.x1, tile_x1);
+        int y0 = std::max(t.y0, tile_y0), y1 = std::min(t.y1, tile_y1);
+        bool smooth[3];
+        for (int i = 0; i < 3; i++) smooth[i] = antialias && t.smooth[i];
+        float affine_inv_q = 1 / t.q[0];
+        for (int y = y0; y <= y1; y++) {
+            float py = y + 0.5f;
+            PixelRGBA *row = dst + static_cast<size_t>(y) * dst_size.w;
+            for (int x = x0; x <= x1; x++) {
+                float px = x + 0.5f;
+                float e[3];
+                float coverage = 1;
+                bool inside = true;
+                for (int i = 0; i < 3; i++) {
+                    // 足し込みで進めると誤差が両半分で食い違うので画素毎に評価する
+                    float raw = t.ea[i] * px + t.eb[i] * py + t.ec[i];
+                    e[i] = raw * t.side[i];
+                    if (smooth[i]) {
+                        coverage = std::min(coverage, e[i] + 0.5f);
+                    } else if (t.side[i] > 0 ? raw < 0 : raw >= 0) {
+                        // 対角線の両半分は同じrawを見て、一方は0以上、他方は負だけを内側とする
+                        inside = false;
+                    }
+                }
+                if (!inside || coverage <= 0)continue;
+                coverage = std::min(coverage, 1.f);
+                float l0 = e[0] * t.bary[0], l1 = e[1] * t.bary[1], l2 = e[2] * t.bary[2];
+                float inv_q = affine_inv_q;
+                if (!t.affine) {
+                    float q = l0 * t.q[0] + l1 * t.q[1] + l2 * t.q[2];
+                    if (q <= 0)continue;
+                    inv_q = 1 / q;
+                }
+                float u = (l0 * t.uq[0] + l1 * t.uq[1] + l2 * t.uq[2]) * inv_q;
+                float v = (l0 * t.vq[0] + l1 * t.vq[1] + l2 * t.vq[2]) * inv_q;
+                float alpha = (l0 * t.aq[0] + l1 * t.aq[1] + l2 * t.aq[2]) * inv_q;
+                PixelRGBA32F s = detail::SamplePremultiplied<Address, Filter>(texture, texture_size, u, v);
+                float k = std::min(std::max(alpha, 0.f), 1.f) * coverage;
+                float sa = s.a * k;
+                if (sa <= 0)continue;
+                // 乗算済みで重ねてから元に戻す
+                PixelRGBA &d = row[x];
+                float keep = 1 - sa * (1.f / 255), da = d.a * keep, dm = da * (1.f / 255);
+                float oa = sa + da;
+                float inv = 1 / oa;
+                auto q8 = [](float c) { return static_cast<byte>(std::min(std::max(c + 0.5f, 0.f), 255.f)); };
+                d = PixelRGBA(q8((s.r * k + d.r * dm) * inv * 255), q8((s.g * k + d.g * dm) * inv * 255),
+                              q8((s.b * k + d.b * dm) * inv * 255), q8(oa));
+            }
+        }
+    }
+}
+
+inline bool aut::Rasterizer::RenderObject(lua_State *L, SamplingAddressMode address, SamplingFilterMode filter,
+                                          bool antialias) {
+    PixelRGBA *data;
+    Size2D size;
+    getpixeldata(L, &data, &size);
+    size_t n = static_cast<size_t>(size.w) * size.h;
+    // テクスチャは元の画像の複製で、出力先は透明にしてから描く
+    ScratchImage texture = ImagePool::Default().Get(Size2D(static_cast<unsigned int>(n), 1));
+    if (!texture.IsValid())return false;
+    std::copy(data, data + n, texture.Data());
+    std::fill(data, data + n, PixelRGBA());
+    Render(data, size, texture.Data(), size, address, filter, antialias);
+    putpixeldata(L, data);
+    return true;
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_RASTER_H_
@@ -0,0 +1,203 @@
+/**
+ * @file AUL_Sampling.h
+ * @author SEED264
+ * @brief Sampling functions for pixel buffers
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_SAMPLING_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_SAMPLING_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <glm/vec2.hpp>
+#include "./AUL_Enum.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Sample a pixel buffer
+     * Pixel (i, j) covers [i, i + 1) x [j, j + 1), so its center is (i + 0.5, j + 0.5).
+     * Linear filtering weights colors by alpha to avoid dark fringes.
+     *
+     * @param[in] src Pixel data
+     * @param[in] size Image size
+     * @param[in] x,y Coords to sample
+     * @param[in] address Addressing mode outside the image
+     * @param[in] filter Filter mode
+     *
+     * @return PixelRGBA Sampled pixel
+     */
+    PixelRGBA Sample(const PixelRGBA *src, Size2D size, float x, float y,
+                     SamplingAddressMode address = kAutAddressBorder,
+                     SamplingFilterMode filter = kAutFilterLinear);
+    /**
+     * Sample a pixel buffer with normalized coords
+     * (0, 0) is the top-left corner and (1, 1) is the bottom-right corner.
+     *
+     * @param[in] src Pixel data
+     * @param[in] size Image size
+     * @param[in] uv Coords to sample
+     * @param[in] address Addressing mode outside the image
+     * @param[in] filter Filter mode
+     *
+     * @return PixelRGBA Sampled pixel
+     */
+    PixelRGBA SampleUV(const PixelRGBA *src, Size2D size, glm::dvec2 uv,
+                       SamplingAddressMode address = kAutAddressBorder,
+                       SamplingFilterMode filter = kAutFilterLinear);
+
+    namespace detail {
+        // アドレッシングモードに従って座標をバッファ内に写す
+        // 範囲外で参照しない場合はfalseを返す
+        template<SamplingAddressMode Address>
+        bool ResolveAddress(int i, int n, int *out);
+        template<SamplingAddressMode Address>
+        PixelRGBA32F FetchPremultiplied(const PixelRGBA *src, Size2D size, int x, int y);
+        /**
+         * Sample as premultiplied color (0 ~ 255)
+         */
+        template<SamplingAddressMode Address, SamplingFilterMode Filter>
+        PixelRGBA32F SamplePremultiplied(const PixelRGBA *src, Size2D size, float x, float y);
+        PixelRGBA Unpremultiply(const PixelRGBA32F &c);
+        // 実行時のモード指定をテンプレートの実体に振り分ける
+        template<typename Func>
+        void DispatchSampling(SamplingAddressMode address, SamplingFilterMode filter, Func func);
+    }
+}
+
+template<aut::SamplingAddressMode Address>
+inline bool aut::detail::ResolveAddress(int i, int n, int *out) {
+    if (i >= 0 && i < n) {
+        *out = i;
+        return true;
+    }
+    switch (Address) {
+    case kAutAddressClamp:
+        *out = i < 0 ? 0 : n - 1;
+        return true;
+    case kAutAddressRepeat:
+        *out = ((i % n) + n) % n;
+        return true;
+    case kAutAddressMirror: {
+        int period = 2 * n;
+        int m = ((i % period) + period) % period;
+        *out = m < n ? m : period - 1 - m;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+template<aut::SamplingAddressMode Address>
+inline aut::PixelRGBA32F aut::detail::FetchPremultiplied(const PixelRGBA *src, Size2D size, int x, int y) {
+    int rx, ry;
+    if (!ResolveAddress<Address>(x, static_cast<int>(size.w), &rx) ||
+        !ResolveAddress<Address>(y, static_cast<int>(size.h), &ry))
+        return PixelRGBA32F();
+    const PixelRGBA &p = src[static_cast<size_t>(ry) * size.w + rx];
+    float a = p.a * (1.f / 255);
+    return PixelRGBA32F(p.r * a, p.g * a, p.b * a, p.a);
+}
+
+template<aut::SamplingAddressMode Address, aut::SamplingFilterMode Filter>
+inline aut::PixelRGBA32F aut::detail::SamplePremultiplied(const PixelRGBA *src, Size2D size,
+                                                          float x, float y) {
+    if (size.w == 0 || size.h == 0)return PixelRGBA32F();
+    if (Filter == kAutFilterNearest) {
+        return FetchPremultiplied<Address>(src, size, static_cast<int>(std::floor(x)),
+                                           static_cast<int>(std::floor(y)));
+    }
+    float fx = x - 0.5f, fy = y - 0.5f;
+    float x0f = std::floor(fx), y0f = std::floor(fy);
+    float tx = fx - x0f, ty = fy - y0f;
+    int x0 = static_cast<int>(x0f), y0 = static_cast<int>(y0f);
+    PixelRGBA32F p00 = FetchPremultiplied<Address>(src, size, x0, y0);
+    PixelRGBA32F p10 = FetchPremultiplied<Address>(src, size, x0 + 1, y0);
+    PixelRGBA32F p01 = FetchPremultiplied<Address>(src, size, x0, y0 + 1);
+    PixelRGBA32F p11 = FetchPremultiplied<Address>(src, size, x0 + 1, y0 + 1);
+    float w00 = (1 - tx) * (1 - ty), w10 = tx * (1 - ty), w01 = (1 - tx) * ty, w11 = tx * ty;
+    return PixelRGBA32F(p00.r * w00 + p10.r * w10 + p01.r * w01 + p11.r * w11,
+                        p00.g * w00 + p10.g * w10 + p01.g * w01 + p11.g * w11,
+                        p00.b * w00 + p10.b * w10 + p01.b * w01 + p11.b * w11,
+                        p00.a * w00 + p10.a * w10 + p01.a * w01 + p11.a * w11);
+}
+
+inline aut::PixelRGBA aut::detail::Unpremultiply(const PixelRGBA32F &c) {
+    if (c.a <= 0)return PixelRGBA();
+    float s = 255.f / c.a;
+    auto q = [](float v) { return static_cast<byte>(std::min(std::max(v + 0.5f, 0.f), 255.f)); };
+    return PixelRGBA(q(c.r * s), q(c.g * s), q(c.b * s), q(c.a));
+}
+
+template<typename Func>
+inline void aut::detail::DispatchSampling(SamplingAddressMode address, SamplingFilterMode filter,
+                                          Func func) {
+    auto with_address = [&](auto address_tag) {
+        if (filter == kAutFilterNearest)
+            func(address_tag, std::integral_constant<SamplingFilterMode, kAutFilterNearest>());
+        else if (filter == kAutFilterTrilinear)
+            func(address_tag, std::integral_constant<SamplingFilterMode, kAutFilterTrilinear>());
+        else
+            func(address_tag, std::integral_constant<SamplingFilterMode, kAutFilterLinear>());
+    };
+    switch (address) {
+    case kAutAddressClamp:
+        with_address(std::integral_constant<SamplingAddressMode, kAutAddressClamp>());
+        break;
+    case kAutAddressRepeat:
+        with_address(std::integral_constant<SamplingAddressMode, kAutAddressRepeat>());
+        break;
+    case kAutAddressMirror:
+        with_address(std::integral_constant<SamplingAddressMode, kAutAddressMirror>());
+        break;
+    default:
+        with_address(std::integral_constant<SamplingAddressMode, kAutAddressBorder>());
+        break;
+    }
+}
+
+inline aut::PixelRGBA aut::Sample(const PixelRGBA *src, Size2D size, float x, float y,
+                                  SamplingAddressMode address, SamplingFilterMode filter) {
+    PixelRGBA32F c;
+    detail::DispatchSampling(address, filter, [&](auto a, auto f) {
+        c = detail::SamplePremultiplied<decltype(a)::value, decltype(f)::value>(src, size, x, y);
+    });
+    return detail::Unpremultiply(c);
+}
+
+inline aut::PixelRGBA aut::SampleUV(const PixelRGBA *src, Size2D size, glm::dvec2 uv,
+                                    SamplingAddressMode address, SamplingFilterMode filter) {
+    return Sample(src, size, static_cast<float>(uv.x * size.w), static_cast<float>(uv.y * size.h),
+                  address, filter);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_SAMPLING_H_
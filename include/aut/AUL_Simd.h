@@ -0,0 +1,767 @@
+/**
+ * @file AUL_Simd.h
+ * @author SEED264
+ * @brief Minimal 8-lane SIMD types shared by the native kernels
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_SIMD_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_SIMD_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AUT_SIMD_AVX2 1
+#endif
+#include "./AUL_Type.h"
+
+namespace aut {
+namespace simd {
+    /**
+     * Number of lanes processed by one vector
+     * The scalar fallback keeps the same width so that kernels produce
+     * identical results with and without AVX2.
+     */
+    constexpr size_t kLanes = 8;
+
+    /**
+     * 8 lanes of 32-bit integers
+     * Lanes are unsigned, ToFloat and ToInt treat them as signed.
+     */
+    struct VUInt {
+#ifdef AUT_SIMD_AVX2
+        __m256i v;
+#else
+        uint v[kLanes];
+#endif
+    };
+
+    /**
+     * 8 lanes of single precision floats
+     */
+    struct VFloat {
+#ifdef AUT_SIMD_AVX2
+        __m256 v;
+#else
+        float v[kLanes];
+#endif
+    };
+
+    /**
+     * Result of lane-wise comparisons
+     */
+    struct VMask {
+#ifdef AUT_SIMD_AVX2
+        __m256 v;
+#else
+        bool v[kLanes];
+#endif
+    };
+
+    /**
+     * Broadcast a value to all lanes
+     */
+    VUInt Set1(uint value);
+    /**
+     * Broadcast a value to all lanes
+     */
+    VFloat Set1(float value);
+    /**
+     * Make a vector of (base, base + 1, ..., base + 7)
+     */
+    VUInt Iota(uint base);
+    /**
+     * Load 8 values (unaligned)
+     */
+    VUInt Load(const uint *src);
+    /**
+     * Load 8 values (unaligned)
+     */
+    VFloat Load(const float *src);
+    /**
+     * Store 8 values (unaligned)
+     */
+    void Store(uint *dst, VUInt a);
+    /**
+     * Store 8 values (unaligned)
+     */
+    void Store(float *dst, VFloat a);
+
+    /**
+     * Load 8 unsigned bytes as floats (0 ~ 255)
+     */
+    VFloat LoadU8(const byte *src);
+    /**
+     * Round to nearest and store as 8 unsigned bytes (saturated)
+     */
+    void StoreU8(byte *dst, VFloat a);
+    /**
+     * Load 8 unsigned shorts as floats (0 ~ 65535)
+     */
+    VFloat LoadU16(const unsigned short *src);
+    /**
+     * Round to nearest and store as 8 unsigned shorts (saturated)
+     */
+    void StoreU16(unsigned short *dst, VFloat a);
+    /**
+     * Load 8 half precision floats
+     */
+    VFloat LoadHalf(const unsigned short *src);
+    /**
+     * Store as 8 half precision floats (round to nearest even)
+     */
+    void StoreHalf(unsigned short *dst, VFloat a);
+    /**
+     * Convert a half precision float to single precision
+     */
+    float HalfToFloat(unsigned short h);
+    /**
+     * Convert a single precision float to half precision (round to nearest even)
+     */
+    unsigned short FloatToHalf(float f);
+
+    /**
+     * Load table[index] of each lane
+     */
+    VFloat Gather(const float *table, VUInt index);
+    /**
+     * Load table[index] of each lane
+     */
+    VUInt Gather(const uint *table, VUInt index);
+
+    /**
+     * Load 8 pixels and split them into channels (0 ~ 255)
+     */
+    void LoadPixels(const PixelRGBA *src, VFloat *b, VFloat *g, VFloat *r, VFloat *a);
+    /**
+     * Round, saturate and store channels as 8 pixels
+     */
+    void StorePixels(PixelRGBA *dst, VFloat b, VFloat g, VFloat r, VFloat a);
+
+    VUInt operator+(VUInt a, VUInt b);
+    VUInt operator-(VUInt a, VUInt b);
+    /**
+     * Lower 32 bits of the lane-wise product
+     */
+    VUInt operator*(VUInt a, VUInt b);
+    VUInt operator&(VUInt a, VUInt b);
+    VUInt operator^(VUInt a, VUInt b);
+    VUInt ShiftRight(VUInt a, int count);
+    /**
+     * Full 32x32->64 multiplication of each lane by a constant
+     *
+     * @param[out] out_hi Upper 32 bits of the products
+     * @param[out] out_lo Lower 32 bits of the products
+     */
+    void MulWide(VUInt a, uint m, VUInt *out_hi, VUInt *out_lo);
+
+    VFloat operator+(VFloat a, VFloat b);
+    VFloat operator-(VFloat a, VFloat b);
+    VFloat operator*(VFloat a, VFloat b);
+    VFloat operator/(VFloat a, VFloat b);
+    VFloat operator-(VFloat a);
+    VFloat Min(VFloat a, VFloat b);
+    VFloat Max(VFloat a, VFloat b);
+    VFloat Floor(VFloat a);
+    /**
+     * Convert signed integer lanes to float
+     */
+    VFloat ToFloat(VUInt a);
+    /**
+     * Convert float lanes to signed integers (truncation)
+     */
+    VUInt ToInt(VFloat a);
+
+    VMask operator>(VFloat a, VFloat b);
+    VMask operator>=(VFloat a, VFloat b);
+    VMask operator==(VUInt a, VUInt b);
+    VMask operator&(VMask a, VMask b);
+    VMask operator|(VMask a, VMask b);
+    VMask operator!(VMask a);
+    /**
+     * Lanes where any of the bits are set
+     */
+    VMask TestBits(VUInt a, uint bits);
+    /**
+     * Lane-wise (mask ? a : b)
+     */
+    VFloat Select(VMask mask, VFloat a, VFloat b);
+
+    /**
+     * Byte-wise maximum of n bytes (dst may be the same as a or b)
+     */
+    void MaxBytes(byte *dst, const byte *a, const byte *b, size_t n);
+    /**
+     * Byte-wise minimum of n bytes (dst may be the same as a or b)
+     */
+    void MinBytes(byte *dst, const byte *a, const byte *b, size_t n);
+}
+}
+
+inline float aut::simd::HalfToFloat(unsigned short h) {
+    uint sign = static_cast<uint>(h & 0x8000) << 16;
+    uint exp = (h >> 10) & 0x1F;
+    uint mant = h & 0x3FF;
+    uint bits;
+    if (exp == 0x1F) {
+        bits = sign | 0x7F800000 | (mant << 13);
+    } else if (exp != 0) {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    } else if (mant == 0) {
+        bits = sign;
+    } else {
+        // 非正規化数を正規化する
+        exp = 113;
+        while (!(mant & 0x400)) {
+            mant <<= 1;
+            exp--;
+        }
+        bits = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline unsigned short aut::simd::FloatToHalf(float f) {
+    uint bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    uint sign = (bits >> 16) & 0x8000;
+    uint abs_bits = bits & 0x7FFFFFFF;
+    if (abs_bits >= 0x7F800000) {
+        // Inf, NaN
+        return static_cast<unsigned short>(sign | 0x7C00 | (abs_bits > 0x7F800000 ? 0x200 : 0));
+    }
+    if (abs_bits >= 0x477FF000) {
+        // halfの最大値を超えるものはInfにする
+        return static_cast<unsigned short>(sign | 0x7C00);
+    }
+    if (abs_bits < 0x38800000) {
+        // 非正規化数 (0.5ulp未満は0)
+        if (abs_bits < 0x33000000)return static_cast<unsigned short>(sign);
+        uint exp = abs_bits >> 23;
+        uint mant = (abs_bits & 0x7FFFFF) | 0x800000;
+        uint shift = 126 - exp;
+        uint half_mant = mant >> shift;
+        uint rest = mant & ((1u << shift) - 1);
+        uint halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half_mant & 1)))half_mant++;
+        return static_cast<unsigned short>(sign | half_mant);
+    }
+    uint h = ((abs_bits - 0x38000000) >> 13);
+    uint rest = abs_bits & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))h++;
+    return static_cast<unsigned short>(sign | h);
+}
+
+#ifdef AUT_SIMD_AVX2
+
+inline aut::simd::VUInt aut::simd::Set1(uint value) {
+    return { _mm256_set1_epi32(static_cast<int>(value)) };
+}
+
+inline aut::simd::VFloat aut::simd::Set1(float value) {
+    return { _mm256_set1_ps(value) };
+}
+
+inline aut::simd::VUInt aut::simd::Iota(uint base) {
+    return { _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(base)),
+                              _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)) };
+}
+
+inline aut::simd::VUInt aut::simd::Load(const uint *src) {
+    return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)) };
+}
+
+inline aut::simd::VFloat aut::simd::Load(const float *src) {
+    return { _mm256_loadu_ps(src) };
+}
+
+inline void aut::simd::Store(uint *dst, VUInt a) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), a.v);
+}
+
+inline void aut::simd::Store(float *dst, VFloat a) {
+    _mm256_storeu_ps(dst, a.v);
+}
+
+inline aut::simd::VFloat aut::simd::LoadU8(const byte *src) {
+    __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+    return { _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)) };
+}
+
+inline void aut::simd::StoreU8(byte *dst, VFloat a) {
+    // 変換前にfloatのまま丸める (max_psはNaNのとき第2引数の0を返す)
+    __m256 v = _mm256_min_ps(_mm256_max_ps(a.v, _mm256_setzero_ps()), _mm256_set1_ps(255.f));
+    __m256i i32 = _mm256_cvtps_epi32(v);
+    __m256i u16 = _mm256_packus_epi32(i32, i32);
+    __m256i u8 = _mm256_packus_epi16(u16, u16);
+    u8 = _mm256_permutevar8x32_epi32(u8, _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(u8));
+}
+
+inline aut::simd::VFloat aut::simd::LoadU16(const unsigned short *src) {
+    __m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    return { _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(shorts)) };
+}
+
+inline void aut::simd::StoreU16(unsigned short *dst, VFloat a) {
+    __m256 v = _mm256_min_ps(_mm256_max_ps(a.v, _mm256_setzero_ps()), _mm256_set1_ps(65535.f));
+    __m256i i32 = _mm256_cvtps_epi32(v);
+    __m256i u16 = _mm256_permute4x64_epi64(_mm256_packus_epi32(i32, i32), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(u16));
+}
+
+#ifdef __F16C__
+inline aut::simd::VFloat aut::simd::LoadHalf(const unsigned short *src) {
+    return { _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))) };
+}
+
+inline void aut::simd::StoreHalf(unsigned short *dst, VFloat a) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_cvtps_ph(a.v, _MM_FROUND_TO_NEAREST_INT));
+}
+#else
+inline aut::simd::VFloat aut::simd::LoadHalf(const unsigned short *src) {
+    float f[kLanes];
+    for (size_t i = 0; i < kLanes; i++) f[i] = HalfToFloat(src[i]);
+    return Load(f);
+}
+
+inline void aut::simd::StoreHalf(unsigned short *dst, VFloat a) {
+    float f[kLanes];
+    Store(f, a);
+    for (size_t i = 0; i < kLanes; i++) dst[i] = FloatToHalf(f[i]);
+}
+#endif // __F16C__
+
+inline void aut::simd::LoadPixels(const PixelRGBA *src, VFloat *b, VFloat *g, VFloat *r, VFloat *a) {
+    __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    __m256i m = _mm256_set1_epi32(0xFF);
+    b->v = _mm256_cvtepi32_ps(_mm256_and_si256(p, m));
+    g->v = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 8), m));
+    r->v = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 16), m));
+    a->v = _mm256_cvtepi32_ps(_mm256_srli_epi32(p, 24));
+}
+
+inline void aut::simd::StorePixels(PixelRGBA *dst, VFloat b, VFloat g, VFloat r, VFloat a) {
+    const __m256 lo = _mm256_setzero_ps(), hi = _mm256_set1_ps(255.f);
+    auto q = [&](__m256 v) { return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v, lo), hi)); };
+    __m256i p = _mm256_or_si256(_mm256_or_si256(q(b.v), _mm256_slli_epi32(q(g.v), 8)),
+                                _mm256_or_si256(_mm256_slli_epi32(q(r.v), 16), _mm256_slli_epi32(q(a.v), 24)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), p);
+}
+
+inline aut::simd::VFloat aut::simd::Gather(const float *table, VUInt index) {
+    return { _mm256_i32gather_ps(table, index.v, 4) };
+}
+
+inline aut::simd::VUInt aut::simd::Gather(const uint *table, VUInt index) {
+    return { _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), index.v, 4) };
+}
+
+inline aut::simd::VUInt aut::simd::operator+(VUInt a, VUInt b) {
+    return { _mm256_add_epi32(a.v, b.v) };
+}
+
+inline aut::simd::VUInt aut::simd::operator-(VUInt a, VUInt b) {
+    return { _mm256_sub_epi32(a.v, b.v) };
+}
+
+inline aut::simd::VUInt aut::simd::operator*(VUInt a, VUInt b) {
+    return { _mm256_mullo_epi32(a.v, b.v) };
+}
+
+inline aut::simd::VUInt aut::simd::operator&(VUInt a, VUInt b) {
+    return { _mm256_and_si256(a.v, b.v) };
+}
+
+inline aut::simd::VUInt aut::simd::operator^(VUInt a, VUInt b) {
+    return { _mm256_xor_si256(a.v, b.v) };
+}
+
+inline aut::simd::VUInt aut::simd::ShiftRight(VUInt a, int count) {
+    return { _mm256_srli_epi32(a.v, count) };
+}
+
+inline void aut::simd::MulWide(VUInt a, uint m, VUInt *out_hi, VUInt *out_lo) {
+    const __m256i vm = _mm256_set1_epi32(static_cast<int>(m));
+    // 偶数レーンと奇数レーンを別々に64bit乗算し、上位・下位を組み直す
+    __m256i even = _mm256_mul_epu32(a.v, vm);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a.v, 32), vm);
+    out_lo->v = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    out_hi->v = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+inline aut::simd::VFloat aut::simd::operator+(VFloat a, VFloat b) {
+    return { _mm256_add_ps(a.v, b.v) };
+}
+
+inline aut::simd::VFloat aut::simd::operator-(VFloat a, VFloat b) {
+    return { _mm256_sub_ps(a.v, b.v) };
+}
+
+inline aut::simd::VFloat aut::simd::operator*(VFloat a, VFloat b) {
+    return { _mm256_mul_ps(a.v, b.v) };
+}
+
+inline aut::simd::VFloat aut::simd::operator/(VFloat a, VFloat b) {
+    return { _mm256_div_ps(a.v, b.v) };
+}
+
+inline aut::simd::VFloat aut::simd::operator-(VFloat a) {
+    return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.f)) };
+}
+
+inline aut::simd::VFloat aut::simd::Min(VFloat a, VFloat b) {
+    return { _mm256_min_ps(a.v, b.v) };
+}
+
+inline aut::simd::VFloat aut::simd::Max(VFloat a, VFloat b) {
+    return { _mm256_max_ps(a.v, b.v) };
+}
+
+inline aut::simd::VFloat aut::simd::Floor(VFloat a) {
+    return { _mm256_floor_ps(a.v) };
+}
+
+inline aut::simd::VFloat aut::simd::ToFloat(VUInt a) {
+    return { _mm256_cvtepi32_ps(a.v) };
+}
+
+inline aut::simd::VUInt aut::simd::ToInt(VFloat a) {
+    return { _mm256_cvttps_epi32(a.v) };
+}
+
+inline aut::simd::VMask aut::simd::operator>(VFloat a, VFloat b) {
+    return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) };
+}
+
+inline aut::simd::VMask aut::simd::operator>=(VFloat a, VFloat b) {
+    return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) };
+}
+
+inline aut::simd::VMask aut::simd::operator==(VUInt a, VUInt b) {
+    return { _mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v)) };
+}
+
+inline aut::simd::VMask aut::simd::operator&(VMask a, VMask b) {
+    return { _mm256_and_ps(a.v, b.v) };
+}
+
+inline aut::simd::VMask aut::simd::operator|(VMask a, VMask b) {
+    return { _mm256_or_ps(a.v, b.v) };
+}
+
+inline aut::simd::VMask aut::simd::operator!(VMask a) {
+    return { _mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1))) };
+}
+
+inline aut::simd::VMask aut::simd::TestBits(VUInt a, uint bits) {
+    __m256i masked = _mm256_and_si256(a.v, _mm256_set1_epi32(static_cast<int>(bits)));
+    __m256i zero = _mm256_cmpeq_epi32(masked, _mm256_setzero_si256());
+    return !VMask{ _mm256_castsi256_ps(zero) };
+}
+
+inline aut::simd::VFloat aut::simd::Select(VMask mask, VFloat a, VFloat b) {
+    return { _mm256_blendv_ps(b.v, a.v, mask.v) };
+}
+
+inline void aut::simd::MaxBytes(byte *dst, const byte *a, const byte *b, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_max_epu8(va, vb));
+    }
+    for (; i < n; i++) dst[i] = a[i] > b[i] ? a[i] : b[i];
+}
+
+inline void aut::simd::MinBytes(byte *dst, const byte *a, const byte *b, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_min_epu8(va, vb));
+    }
+    for (; i < n; i++) dst[i] = a[i] < b[i] ? a[i] : b[i];
+}
+
+#else
+
+inline aut::simd::VUInt aut::simd::Set1(uint value) {
+    VUInt r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = value;
+    return r;
+}
+
+inline aut::simd::VFloat aut::simd::Set1(float value) {
+    VFloat r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = value;
+    return r;
+}
+
+inline aut::simd::VUInt aut::simd::Iota(uint base) {
+    VUInt r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = base + static_cast<uint>(i);
+    return r;
+}
+
+inline aut::simd::VUInt aut::simd::Load(const uint *src) {
+    VUInt r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = src[i];
+    return r;
+}
+
+inline aut::simd::VFloat aut::simd::Load(const float *src) {
+    VFloat r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = src[i];
+    return r;
+}
+
+inline void aut::simd::Store(uint *dst, VUInt a) {
+    for (size_t i = 0; i < kLanes; i++) dst[i] = a.v[i];
+}
+
+inline void aut::simd::Store(float *dst, VFloat a) {
+    for (size_t i = 0; i < kLanes; i++) dst[i] = a.v[i];
+}
+
+inline aut::simd::VFloat aut::simd::LoadU8(const byte *src) {
+    VFloat r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = src[i];
+    return r;
+}
+
+inline void aut::simd::StoreU8(byte *dst, VFloat a) {
+    for (size_t i = 0; i < kLanes; i++) {
+        float v = std::nearbyint(a.v[i]);
+        dst[i] = static_cast<byte>(!(v > 0) ? 0 : (v > 255 ? 255 : v));
+    }
+}
+
+inline aut::simd::VFloat aut::simd::LoadU16(const unsigned short *src) {
+    VFloat r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = src[i];
+    return r;
+}
+
+inline void aut::simd::StoreU16(unsigned short *dst, VFloat a) {
+    for (size_t i = 0; i < kLanes; i++) {
+        float v = std::nearbyint(a.v[i]);
+        dst[i] = static_cast<unsigned short>(!(v > 0) ? 0 : (v > 65535 ? 65535 : v));
+    }
+}
+
+inline aut::simd::VFloat aut::simd::LoadHalf(const unsigned short *src) {
+    VFloat r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = HalfToFloat(src[i]);
+    return r;
+}
+
+inline void aut::simd::StoreHalf(unsigned short *dst, VFloat a) {
+    for (size_t i = 0; i < kLanes; i++) dst[i] = FloatToHalf(a.v[i]);
+}
+
+inline void aut::simd::LoadPixels(const PixelRGBA *src, VFloat *b, VFloat *g, VFloat *r, VFloat *a) {
+    for (size_t i = 0; i < kLanes; i++) {
+        b->v[i] = src[i].b;
+        g->v[i] = src[i].g;
+        r->v[i] = src[i].r;
+        a->v[i] = src[i].a;
+    }
+}
+
+inline void aut::simd::StorePixels(PixelRGBA *dst, VFloat b, VFloat g, VFloat r, VFloat a) {
+    auto q = [](float v) {
+        v = std::nearbyint(v);
+        return static_cast<byte>(!(v > 0) ? 0 : (v > 255 ? 255 : v));
+    };
+    for (size_t i = 0; i < kLanes; i++) {
+        dst[i] = PixelRGBA(q(r.v[i]), q(g.v[i]), q(b.v[i]), q(a.v[i]));
+    }
+}
+
+inline aut::simd::VFloat aut::simd::Gather(const float *table, VUInt index) {
+    VFloat r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = table[index.v[i]];
+    return r;
+}
+
+inline aut::simd::VUInt aut::simd::Gather(const uint *table, VUInt index) {
+    VUInt r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = table[index.v[i]];
+    return r;
+}
+
+inline aut::simd::VUInt aut::simd::operator+(VUInt a, VUInt b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] += b.v[i];
+    return a;
+}
+
+inline aut::simd::VUInt aut::simd::operator-(VUInt a, VUInt b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] -= b.v[i];
+    return a;
+}
+
+inline aut::simd::VUInt aut::simd::operator*(VUInt a, VUInt b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] *= b.v[i];
+    return a;
+}
+
+inline aut::simd::VUInt aut::simd::operator&(VUInt a, VUInt b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] &= b.v[i];
+    return a;
+}
+
+inline aut::simd::VUInt aut::simd::operator^(VUInt a, VUInt b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] ^= b.v[i];
+    return a;
+}
+
+inline aut::simd::VUInt aut::simd::ShiftRight(VUInt a, int count) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] >>= count;
+    return a;
+}
+
+inline void aut::simd::MulWide(VUInt a, uint m, VUInt *out_hi, VUInt *out_lo) {
+    for (size_t i = 0; i < kLanes; i++) {
+        unsigned long long p = static_cast<unsigned long long>(a.v[i]) * m;
+        out_hi->v[i] = static_cast<uint>(p >> 32);
+        out_lo->v[i] = static_cast<uint>(p);
+    }
+}
+
+inline aut::simd::VFloat aut::simd::operator+(VFloat a, VFloat b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] += b.v[i];
+    return a;
+}
+
+inline aut::simd::VFloat aut::simd::operator-(VFloat a, VFloat b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] -= b.v[i];
+    return a;
+}
+
+inline aut::simd::VFloat aut::simd::operator*(VFloat a, VFloat b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] *= b.v[i];
+    return a;
+}
+
+inline aut::simd::VFloat aut::simd::operator/(VFloat a, VFloat b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] /= b.v[i];
+    return a;
+}
+
+inline aut::simd::VFloat aut::simd::operator-(VFloat a) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] = -a.v[i];
+    return a;
+}
+
+inline aut::simd::VFloat aut::simd::Min(VFloat a, VFloat b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i];
+    return a;
+}
+
+inline aut::simd::VFloat aut::simd::Max(VFloat a, VFloat b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] = b.v[i] > a.v[i] ? b.v[i] : a.v[i];
+    return a;
+}
+
+inline aut::simd::VFloat aut::simd::Floor(VFloat a) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] = std::floor(a.v[i]);
+    return a;
+}
+
+inline aut::simd::VFloat aut::simd::ToFloat(VUInt a) {
+    VFloat r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = static_cast<float>(static_cast<int>(a.v[i]));
+    return r;
+}
+
+inline aut::simd::VUInt aut::simd::ToInt(VFloat a) {
+    VUInt r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = static_cast<uint>(static_cast<int>(a.v[i]));
+    return r;
+}
+
+inline aut::simd::VMask aut::simd::operator>(VFloat a, VFloat b) {
+    VMask r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = a.v[i] > b.v[i];
+    return r;
+}
+
+inline aut::simd::VMask aut::simd::operator>=(VFloat a, VFloat b) {
+    VMask r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = a.v[i] >= b.v[i];
+    return r;
+}
+
+inline aut::simd::VMask aut::simd::operator==(VUInt a, VUInt b) {
+    VMask r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = a.v[i] == b.v[i];
+    return r;
+}
+
+inline aut::simd::VMask aut::simd::operator&(VMask a, VMask b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] = a.v[i] && b.v[i];
+    return a;
+}
+
+inline aut::simd::VMask aut::simd::operator|(VMask a, VMask b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] = a.v[i] || b.v[i];
+    return a;
+}
+
+inline aut::simd::VMask aut::simd::operator!(VMask a) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] = !a.v[i];
+    return a;
+}
+
+inline aut::simd::VMask aut::simd::TestBits(VUInt a, uint bits) {
+    VMask r;
+    for (size_t i = 0; i < kLanes; i++) r.v[i] = (a.v[i] & bits) != 0;
+    return r;
+}
+
+inline aut::simd::VFloat aut::simd::Select(VMask mask, VFloat a, VFloat b) {
+    for (size_t i = 0; i < kLanes; i++) a.v[i] = mask.v[i] ? a.v[i] : b.v[i];
+    return a;
+}
+
+inline void aut::simd::MaxBytes(byte *dst, const byte *a, const byte *b, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = a[i] > b[i] ? a[i] : b[i];
+}
+
+inline void aut::simd::MinBytes(byte *dst, const byte *a, const byte *b, size_t n) {
+    for (size_t i = 0; i < n; i++) dst[i] = a[i] < b[i] ? a[i] : b[i];
+}
+
+#endif // AUT_SIMD_AVX2
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_SIMD_H_
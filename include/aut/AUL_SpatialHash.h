@@ -0,0 +1,359 @@
+/**
+ * @file AUL_SpatialHash.h
+ * @author SEED264
+ * @brief Uniform spatial hash for neighbour queries
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_SPATIALHASH_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_SPATIALHASH_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include "./AUL_Parallel.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Uniform spatial hash of a point set
+     *
+     * Points are bucketed by the hash of their cell with a counting sort
+     * into flat arrays, so a rebuild is linear and makes no per-cell
+     * allocations. Radius and k-nearest queries only visit the cells around
+     * the query. Indices in results refer to the order of the input points
+     * (0-based). Pairs are stored flat as {i0, j0, i1, j1, ...}, which
+     * PushVectorArray(L, 2, pairs.data(), 2, n) can hand to Lua.
+     */
+    class SpatialHash {
+    public:
+        static constexpr uint kInvalidIndex = 0xFFFFFFFFu;
+
+        SpatialHash();
+
+        /**
+         * Build from points with dims (2 or 3) components each
+         *
+         * @param[in] points Coords, the i-th point starts at points[i * stride]
+         * @param[in] stride Number of elements from a point to the next one
+         * @param[in] dims Number of components (z = 0 if 2)
+         * @param[in] count Number of points
+         * @param[in] cell_size Size of a cell (about the typical query radius)
+         */
+        template<typename T>
+        void Build(const T *points, size_t stride, size_t dims, size_t count, double cell_size);
+        void Build(const std::vector<glm::dvec2> &points, double cell_size);
+        void Build(const std::vector<glm::dvec3> &points, double cell_size);
+
+        size_t Size() const;
+        double CellSize() const;
+
+        /**
+         * Find the points within radius of center
+         *
+         * @param[in] center Query point
+         * @param[in] radius Query radius (inclusive)
+         * @param[out] out Indices are appended here
+         *
+         * @return size_t Number of points found
+         */
+        size_t QueryRadius(glm::dvec3 center, double radius, std::vector<uint> *out) const;
+        /**
+         * Find the k nearest points of center, closest first
+         * Unused entries are set to kInvalidIndex.
+         *
+         * @param[in] center Query point
+         * @param[in] k Number of points to find
+         * @param[out] out_index k indices
+         * @param[out] out_distance k distances (may be nullptr)
+         * @param[in] exclude Index to skip (e.g. the query point itself)
+         *
+         * @return size_t Number of points found
+         */
+        size_t KNearest(glm::dvec3 center, size_t k, uint *out_index, double *out_distance = nullptr,
+                        uint exclude = kInvalidIndex) const;
+        /**
+         * Find every pair i < j of points closer than radius (in parallel)
+         * Pairs are ordered by i.
+         *
+         * @param[in] radius Maximum distance (inclusive)
+         * @param[out] pairs Flat pairs {i0, j0, i1, j1, ...}
+         */
+        void FindPairs(double radius, std::vector<uint> *pairs) const;
+        /**
+         * Find the k nearest other points of every point (in parallel)
+         *
+         * @param[in] k Number of neighbours per point
+         * @param[out] neighbours Size() * k indices, those of point i start at i * k
+         */
+        void KNearestAll(size_t k, std::vector<uint> *neighbours) const;
+
+    private:
+        struct Cell {
+            int x, y, z;
+        };
+
+        Cell CellOf(double x, double y, double z) const;
+        size_t Bucket(Cell c) const;
+        template<typename Func>
+        void ForEachInCell(Cell c, Func func) const;
+        void Sort(size_t count);
+
+        double cell_size_, inv_cell_;
+        bool is_3d_;
+        size_t mask_;
+        Cell min_cell_, max_cell_;
+        // バケットの先頭位置 (バケット数 + 1個)
+        std::vector<uint> bucket_start_;
+        // バケット順に並べた座標と元のインデックス
+        std::vector<double> x_, y_, z_;
+        std::vector<uint> index_;
+        std::vector<Cell> cell_;
+        // 元のインデックスから並べ替え後の位置
+        std::vector<uint> slot_;
+        std::vector<uint> key_;
+    };
+}
+
+inline aut::SpatialHash::SpatialHash()
+    : cell_size_(1), inv_cell_(1), is_3d_(false), mask_(0), min_cell_(), max_cell_() {}
+
+template<typename T>
+inline void aut::SpatialHash::Build(const T *points, size_t stride, size_t dims, size_t count, double cell_size) {
+    cell_size_ = cell_size > 0 ? cell_size : 1;
+    inv_cell_ = 1 / cell_size_;
+    is_3d_ = dims >= 3;
+    x_.resize(count);
+    y_.resize(count);
+    z_.resize(count);
+    // 一旦入力順に置いてからSortで並べ替える
+    for (size_t i = 0; i < count; i++) {
+        const T *p = points + i * stride;
+        x_[i] = static_cast<double>(p[0]);
+        y_[i] = dims >= 2 ? static_cast<double>(p[1]) : 0.0;
+        z_[i] = is_3d_ ? static_cast<double>(p[2]) : 0.0;
+    }
+    Sort(count);
+}
+
+inline void aut::SpatialHash::Build(const std::vector<glm::dvec2> &points, double cell_size) {
+    Build(reinterpret_cast<const double*>(points.data()), 2, 2, points.size(), cell_size);
+}
+
+inline void aut::SpatialHash::Build(const std::vector<glm::dvec3> &points, double cell_size) {
+    Build(reinterpret_cast<const double*>(points.data()), 3, 3, points.size(), cell_size);
+}
+
+inline void aut::SpatialHash::Sort(size_t count) {
+    size_t table_size = 1;
+    while (table_size < count * 2) table_size <<= 1;
+    mask_ = table_size - 1;
+    key_.resize(count);
+    std::vector<Cell> cells(count);
+    min_cell_ = Cell{ 0, 0, 0 };
+    max_cell_ = Cell{ 0, 0, 0 };
+    for (size_t i = 0; i < count; i++) {
+        Cell c = cells[i] = CellOf(x_[i], y_[i], z_[i]);
+        if (i == 0) {
+            min_cell_ = max_cell_ = c;
+        } else {
+            min_cell_ = Cell{ std::min(min_cell_.x, c.x), std::min(min_cell_.y, c.y), std::min(min_cell_.z, c.z) };
+            max_cell_ = Cell{ std::max(max_cell_.x, c.x), std::max(max_cell_.y, c.y), std::max(max_cell_.z, c.z) };
+        }
+        key_[i] = static_cast<uint>(Bucket(c));
+    }
+    // 計数ソート
+    bucket_start_.assign(table_size + 1, 0);
+    for (size_t i = 0; i < count; i++) bucket_start_[key_[i] + 1]++;
+    for (size_t b = 0; b < table_size; b++) bucket_start_[b + 1] += bucket_start_[b];
+    std::vector<double> x(count), y(count), z(count);
+    index_.resize(count);
+    cell_.resize(count);
+    slot_.resize(count);
+    std::vector<uint> next(bucket_start_.begin(), bucket_start_.end() - 1);
+    for (size_t i = 0; i < count; i++) {
+        uint s = next[key_[i]]++;
+        x[s] = x_[i];
+        y[s] = y_[i];
+        z[s] = z_[i];
+        index_[s] = static_cast<uint>(i);
+        cell_[s] = cells[i];
+        slot_[i] = s;
+    }
+    x_.swap(x);
+    y_.swap(y);
+    z_.swap(z);
+}
+
+inline size_t aut::SpatialHash::Size() const {
+    return index_.size();
+}
+
+inline double aut::SpatialHash::CellSize() const {
+    return cell_size_;
+}
+
+inline aut::SpatialHash::Cell aut::SpatialHash::CellOf(double x, double y, double z) const {
+    return Cell{ static_cast<int>(std::floor(x * inv_cell_)), static_cast<int>(std::floor(y * inv_cell_)),
+                 static_cast<int>(std::floor(z * inv_cell_)) };
+}
+
+inline size_t aut::SpatialHash::Bucket(Cell c) const {
+    uint h = static_cast<uint>(c.x) * 73856093u ^ static_cast<uint>(c.y) * 19349663u ^
+             static_cast<uint>(c.z) * 83492791u;
+    return h & mask_;
+}
+
+template<typename Func>
+inline void aut::SpatialHash::ForEachInCell(Cell c, Func func) const {
+    if (bucket_start_.empty())return;
+    size_t b = Bucket(c);
+    for (uint s = bucket_start_[b]; s < bucket_start_[b + 1]; s++) {
+        // 同じバケットに入った別のセルの点は除く (重複して数えないため)
+        const Cell &pc = cell_[s];
+        if (pc.x == c.x && pc.y == c.y && pc.z == c.z)func(s);
+    }
+}
+
+inline size_t aut::SpatialHash::QueryRadius(glm::dvec3 center, double radius, std::vector<uint> *out) const {
+    if (Size() == 0 || radius < 0)return 0;
+    if (!is_3d_)center.z = 0;
+    double r2 = radius * radius;
+    Cell lo = CellOf(center.x - radius, center.y - radius, center.z - radius);
+    Cell hi = CellOf(center.x + radius, center.y + radius, center.z + radius);
+    lo = Cell{ std::max(lo.x, min_cell_.x), std::max(lo.y, min_cell_.y), std::max(lo.z, min_cell_.z) };
+    hi = Cell{ std::min(hi.x, max_cell_.x), std::min(hi.y, max_cell_.y), std::min(hi.z, max_cell_.z) };
+    size_t found = 0;
+    for (int cz = lo.z; cz <= hi.z; cz++) {
+        for (int cy = lo.y; cy <= hi.y; cy++) {
+            for (int cx = lo.x; cx <= hi.x; cx++) {
+                ForEachInCell(Cell{ cx, cy, cz }, [&](uint s) {
+                    double dx = x_[s] - center.x, dy = y_[s] - center.y, dz = z_[s] - center.z;
+                    if (dx * dx + dy * dy + dz * dz <= r2) {
+                        out->push_back(index_[s]);
+                        found++;
+                    }
+                });
+            }
+        }
+    }
+    return found;
+}
+
+inline size_t aut::SpatialHash::KNearest(glm::dvec3 center, size_t k, uint *out_index, double *out_distance,
+                                         uint exclude) const {
+    if (k == 0)return 0;
+    if (!is_3d_)center.z = 0;
+    // 距離の二乗と並べ替え後の位置の最大ヒープ
+    std::vector<std::pair<double, uint>> heap;
+    heap.reserve(k + 1);
+    if (Size() > 0) {
+        Cell c0 = CellOf(center.x, center.y, center.z);
+        // 全ての点を含むセル範囲を覆うまでの環の数
+        int max_ring = std::max({ c0.x - min_cell_.x, max_cell_.x - c0.x, c0.y - min_cell_.y, max_cell_.y - c0.y,
+                                  c0.z - min_cell_.z, max_cell_.z - c0.z, 0 });
+        // 点のあるセル範囲の外側の環は飛ばす
+        int first_ring = std::max({ min_cell_.x - c0.x, c0.x - max_cell_.x, min_cell_.y - c0.y, c0.y - max_cell_.y,
+                                    min_cell_.z - c0.z, c0.z - max_cell_.z, 0 });
+        for (int ring = first_ring; ring <= max_ring; ring++) {
+            int rz = is_3d_ ? ring : 0;
+            for (int dz = std::max(-rz, min_cell_.z - c0.z); dz <= std::min(rz, max_cell_.z - c0.z); dz++) {
+                for (int dy = std::max(-ring, min_cell_.y - c0.y); dy <= std::min(ring, max_cell_.y - c0.y); dy++) {
+                    for (int dx = std::max(-ring, min_cell_.x - c0.x); dx <= std::min(ring, max_cell_.x - c0.x);
+                         dx++) {
+                        // 環の表面のセルだけを調べる
+                        if (std::max({ std::abs(dx), std::abs(dy), std::abs(dz) }) != ring)continue;
+                        ForEachInCell(Cell{ c0.x + dx, c0.y + dy, c0.z + dz }, [&](uint s) {
+                            if (index_[s] == exclude)return;
+                            double ex = x_[s] - center.x, ey = y_[s] - center.y, ez = z_[s] - center.z;
+                            double d2 = ex * ex + ey * ey + ez * ez;
+                            if (heap.size() == k && d2 >= heap.front().first)return;
+                            heap.emplace_back(d2, s);
+                            std::push_heap(heap.begin(), heap.end());
+                            if (heap.size() > k) {
+                                std::pop_heap(heap.begin(), heap.end());
+                                heap.pop_back();
+                            }
+                        });
+                    }
+                }
+            }
+            // 次の環の点はring * cell_size_より遠い
+            if (heap.size() == k && heap.front().first <= ring * cell_size_ * ring * cell_size_)break;
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end());
+    for (size_t i = 0; i < k; i++) {
+        bool valid = i < heap.size();
+        out_index[i] = valid ? index_[heap[i].second] : kInvalidIndex;
+        if (out_distance)
+            out_distance[i] = valid ? std::sqrt(heap[i].first) : std::numeric_limits<double>::infinity();
+    }
+    return heap.size();
+}
+
+inline void aut::SpatialHash::FindPairs(double radius, std::vector<uint> *pairs) const {
+    pairs->clear();
+    const size_t kBlock = 256;
+    size_t block_num = (Size() + kBlock - 1) / kBlock;
+    std::vector<std::vector<uint>> found(block_num);
+    ParallelFor(0, block_num, [&](size_t b) {
+        std::vector<uint> hits;
+        std::vector<uint> &local = found[b];
+        size_t end = std::min((b + 1) * kBlock, Size());
+        for (size_t i = b * kBlock; i < end; i++) {
+            uint s = slot_[i];
+            hits.clear();
+            QueryRadius(glm::dvec3(x_[s], y_[s], z_[s]), radius, &hits);
+            for (uint j : hits) {
+                if (j <= i)continue;
+                local.push_back(static_cast<uint>(i));
+                local.push_back(j);
+            }
+        }
+    });
+    size_t total = 0;
+    for (const auto &f : found) total += f.size();
+    pairs->reserve(total);
+    for (const auto &f : found) pairs->insert(pairs->end(), f.begin(), f.end());
+}
+
+inline void aut::SpatialHash::KNearestAll(size_t k, std::vector<uint> *neighbours) const {
+    neighbours->assign(Size() * k, kInvalidIndex);
+    if (k == 0)return;
+    ParallelFor(0, Size(), [&](size_t i) {
+        uint s = slot_[i];
+        KNearest(glm::dvec3(x_[s], y_[s], z_[s]), k, neighbours->data() + i * k, nullptr, static_cast<uint>(i));
+    }, 64);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_SPATIALHASH_H_
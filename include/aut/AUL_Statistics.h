@@ -0,0 +1,199 @@
+/**
+ * @file AUL_Statistics.h
+ * @author SEED264
+ * @brief Image statistics and histogram reductions
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_STATISTICS_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_STATISTICS_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "./AUL_Parallel.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    // チャンネル毎の統計情報用の構造体
+    struct ChannelStats {
+        unsigned int histogram[256];
+        byte min;
+        byte max;
+        double mean;
+        double variance;
+
+        ChannelStats() : histogram(), min(0), max(0), mean(0), variance(0) {}
+
+        /**
+         * Smallest value whose cumulative count reaches fraction of the pixels
+         * (e.g. 0.01 and 0.99 for auto-levels)
+         */
+        byte Percentile(double fraction) const {
+            unsigned long long total = 0;
+            for (unsigned int n : histogram) total += n;
+            if (total == 0)return 0;
+            double target = std::min(std::max(fraction, 0.0), 1.0) * total;
+            unsigned long long sum = 0;
+            for (int i = 0; i < 256; i++) {
+                sum += histogram[i];
+                if (sum >= target && sum > 0)return static_cast<byte>(i);
+            }
+            return 255;
+        }
+    };
+
+    // 画像の統計情報用の構造体
+    struct ImageStats {
+        // 集計した画素数
+        size_t count;
+        ChannelStats r;
+        ChannelStats g;
+        ChannelStats b;
+        ChannelStats a;
+        // 輝度 (BT.709、0.2126R + 0.7152G + 0.0722B)
+        ChannelStats luma;
+
+        ImageStats() : count(0) {}
+    };
+
+    /**
+     * Compute histograms and statistics of a pixel buffer
+     * Rows are split between threads, each filling private histograms that
+     * are merged at the end. Min, max, mean and variance are derived exactly
+     * from the histograms.
+     *
+     * @param[in] data Pixel data
+     * @param[in] size Image size
+     * @param[in] min_alpha Pixels with smaller alpha are not counted
+     *
+     * @return ImageStats Statistics
+     */
+    ImageStats ComputeStats(const PixelRGBA *data, Size2D size, byte min_alpha = 0);
+    /**
+     * Compute histograms and statistics of a rectangle of a pixel buffer
+     * The rectangle must be inside the buffer.
+     *
+     * @param[in] data Pixel data
+     * @param[in] stride Number of pixels per row of data
+     * @param[in] rect Rectangle to compute
+     * @param[in] min_alpha Pixels with smaller alpha are not counted
+     *
+     * @return ImageStats Statistics
+     */
+    ImageStats ComputeStats(const PixelRGBA *data, size_t stride, Rect2D rect, byte min_alpha = 0);
+
+    namespace detail {
+        // スレッド毎のヒストグラム (b, g, r, a, 輝度の順)
+        struct LocalHistogram {
+            unsigned int bins[5][256];
+        };
+
+        void FinishChannelStats(ChannelStats *stats, size_t count);
+    }
+}
+
+inline void aut::detail::FinishChannelStats(ChannelStats *stats, size_t count) {
+    if (count == 0)return;
+    double sum = 0, sum_sq = 0;
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 256; i++) {
+        unsigned int n = stats->histogram[i];
+        if (!n)continue;
+        lo = std::min(lo, i);
+        hi = std::max(hi, i);
+        sum += static_cast<double>(n) * i;
+        sum_sq += static_cast<double>(n) * i * i;
+    }
+    stats->min = static_cast<byte>(lo);
+    stats->max = static_cast<byte>(hi);
+    stats->mean = sum / count;
+    stats->variance = std::max(sum_sq / count - stats->mean * stats->mean, 0.0);
+}
+
+inline aut::ImageStats aut::ComputeStats(const PixelRGBA *data, size_t stride, Rect2D rect, byte min_alpha) {
+    using namespace simd;
+    ImageStats stats;
+    if (rect.w == 0 || rect.h == 0)return stats;
+    size_t parts = std::min<size_t>(std::max<uint>(GetThreadCount(), 1), rect.h);
+    std::vector<detail::LocalHistogram> local(parts);
+    ParallelFor(0, parts, [&](size_t part) {
+        detail::LocalHistogram &hist = local[part];
+        std::memset(&hist, 0, sizeof(hist));
+        unsigned int y0 = static_cast<unsigned int>(rect.h * part / parts);
+        unsigned int y1 = static_cast<unsigned int>(rect.h * (part + 1) / parts);
+        const VFloat kr = Set1(54.f), kg = Set1(183.f), kb = Set1(19.f);
+        const VFloat bias = Set1(128.f), scale = Set1(1.f / 256);
+        uint luma[kLanes];
+        for (unsigned int y = y0; y < y1; y++) {
+            const PixelRGBA *row = data + static_cast<size_t>(rect.y + y) * stride + rect.x;
+            for (unsigned int x = 0; x < rect.w; x += kLanes) {
+                unsigned int n = std::min<unsigned int>(kLanes, rect.w - x);
+                if (n == kLanes) {
+                    // 整数の重み(合計256)で輝度を求める (floatで誤差なく計算できる範囲)
+                    VFloat b, g, r, a;
+                    LoadPixels(row + x, &b, &g, &r, &a);
+                    Store(luma, ToInt((r * kr + g * kg + b * kb + bias) * scale));
+                } else {
+                    for (unsigned int i = 0; i < n; i++) {
+                        const PixelRGBA &p = row[x + i];
+                        luma[i] = (p.r * 54u + p.g * 183u + p.b * 19u + 128u) >> 8;
+                    }
+                }
+                for (unsigned int i = 0; i < n; i++) {
+                    const PixelRGBA &p = row[x + i];
+                    if (p.a < min_alpha)continue;
+                    hist.bins[0][p.b]++;
+                    hist.bins[1][p.g]++;
+                    hist.bins[2][p.r]++;
+                    hist.bins[3][p.a]++;
+                    hist.bins[4][luma[i]]++;
+                }
+            }
+        }
+    });
+    ChannelStats *channels[5] = { &stats.b, &stats.g, &stats.r, &stats.a, &stats.luma };
+    for (const auto &hist : local) {
+        for (int c = 0; c < 5; c++)
+            for (int i = 0; i < 256; i++)
+                channels[c]->histogram[i] += hist.bins[c][i];
+    }
+    for (int i = 0; i < 256; i++)
+        stats.count += stats.a.histogram[i];
+    for (ChannelStats *c : channels)
+        detail::FinishChannelStats(c, stats.count);
+    return stats;
+}
+
+inline aut::ImageStats aut::ComputeStats(const PixelRGBA *data, Size2D size, byte min_alpha) {
+    return ComputeStats(data, size.w, Rect2D(0, 0, size.w, size.h), min_alpha);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_STATISTICS_H_
@@ -0,0 +1,221 @@
+/**
+ * @file AUL_SummedArea.h
+ * @author SEED264
+ * @brief Summed-area tables for constant-time box filtering
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_SUMMEDAREA_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_SUMMEDAREA_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "./AUL_Parallel.h"
+#include "./AUL_Sampling.h"
+#include "./AUL_Type.h"
+
+namespace aut {
+    /**
+     * Summed-area table of a pixel buffer
+     *
+     * Colors are accumulated weighted by alpha, so averages do not darken
+     * around transparent pixels. The sum of any rectangle is read from four
+     * cells regardless of its size.
+     * Sums wrap around in Accum, and the differences stay exact while the sum
+     * of one rectangle fits in it. With 32-bit accumulators this holds for
+     * rectangles up to 66051 pixels (about 257x257); use 64-bit accumulators
+     * for larger ones.
+     *
+     * @tparam Accum Unsigned integer type of the accumulators
+     */
+    template<typename Accum>
+    class SummedAreaTable {
+    public:
+        SummedAreaTable();
+
+        /**
+         * Build the table from src
+         * Rows are summed in parallel, then columns in parallel bands.
+         *
+         * @param[in] src Pixel data
+         * @param[in] size Image size
+         */
+        void Build(const PixelRGBA *src, Size2D size);
+        Size2D GetSize() const;
+        /**
+         * Average of a rectangle
+         * The rectangle is clipped to the image, and only the pixels inside
+         * are averaged.
+         *
+         * @param[in] rect Rectangle to average
+         *
+         * @return PixelRGBA Average color (transparent if the rectangle is empty)
+         */
+        PixelRGBA Average(Rect2D rect) const;
+        /**
+         * Average of the square of (2 * radius + 1) pixels centered on (x, y)
+         */
+        PixelRGBA Average(int x, int y, int radius) const;
+        /**
+         * Premultiplied average of a rectangle (0 ~ 255)
+         */
+        PixelRGBA32F AveragePremultiplied(Rect2D rect) const;
+
+    private:
+        struct Cell {
+            Accum b, g, r, a;
+        };
+
+        std::vector<Cell> table_;
+        Size2D size_;
+    };
+
+    using SummedAreaTable32 = SummedAreaTable<unsigned int>;
+    using SummedAreaTable64 = SummedAreaTable<unsigned long long>;
+
+    /**
+     * Box blur with a radius per pixel
+     * Fractional radii blend the two nearest integer radii, and every pixel
+     * costs the same regardless of its radius.
+     *
+     * @param[out] dst Destination pixels (must not overlap the table source)
+     * @param[in] sat Table of the source image
+     * @param[in] radius Radius of each pixel (same layout as dst)
+     */
+    template<typename Accum>
+    void BoxBlurVariable(PixelRGBA *dst, const SummedAreaTable<Accum> &sat, const float *radius);
+}
+
+template<typename Accum>
+inline aut::SummedAreaTable<Accum>::SummedAreaTable() {}
+
+template<typename Accum>
+inline void aut::SummedAreaTable<Accum>::Build(const PixelRGBA *src, Size2D size) {
+    size_ = size;
+    const size_t tw = static_cast<size_t>(size.w) + 1;
+    // 上端と左端に0の行と列を持たせて範囲外の判定を省く
+    table_.assign(tw * (static_cast<size_t>(size.h) + 1), Cell());
+    if (size.w == 0 || size.h == 0)return;
+    ParallelFor(0, size.h, [&](size_t y) {
+        const PixelRGBA *row = src + y * size.w;
+        Cell *out = &table_[(y + 1) * tw + 1];
+        Cell sum = Cell();
+        for (unsigned int x = 0; x < size.w; x++) {
+            Accum a = row[x].a;
+            sum.b += row[x].b * a;
+            sum.g += row[x].g * a;
+            sum.r += row[x].r * a;
+            sum.a += a;
+            out[x] = sum;
+        }
+    }, 16);
+    const size_t kBand = 256;
+    ParallelFor(0, (tw + kBand - 1) / kBand, [&](size_t band) {
+        size_t x0 = band * kBand, x1 = std::min(x0 + kBand, tw);
+        for (size_t y = 2; y <= size.h; y++) {
+            const Cell *prev = &table_[(y - 1) * tw];
+            Cell *cur = &table_[y * tw];
+            for (size_t x = x0; x < x1; x++) {
+                cur[x].b += prev[x].b;
+                cur[x].g += prev[x].g;
+                cur[x].r += prev[x].r;
+                cur[x].a += prev[x].a;
+            }
+        }
+    });
+}
+
+template<typename Accum>
+inline aut::Size2D aut::SummedAreaTable<Accum>::GetSize() const {
+    return size_;
+}
+
+template<typename Accum>
+inline aut::PixelRGBA32F aut::SummedAreaTable<Accum>::AveragePremultiplied(Rect2D rect) const {
+    long long x0 = std::max(rect.x, 0), y0 = std::max(rect.y, 0);
+    long long x1 = std::min(static_cast<long long>(rect.x) + rect.w, static_cast<long long>(size_.w));
+    long long y1 = std::min(static_cast<long long>(rect.y) + rect.h, static_cast<long long>(size_.h));
+    if (x0 >= x1 || y0 >= y1)return PixelRGBA32F();
+    const size_t tw = static_cast<size_t>(size_.w) + 1;
+    const Cell &c00 = table_[y0 * tw + x0], &c10 = table_[y0 * tw + x1];
+    const Cell &c01 = table_[y1 * tw + x0], &c11 = table_[y1 * tw + x1];
+    // 途中で桁あふれしていても差を取れば元に戻る
+    auto sum = [&](Accum Cell::*ch) {
+        return static_cast<double>(static_cast<Accum>(c11.*ch - c10.*ch - c01.*ch + c00.*ch));
+    };
+    double area = static_cast<double>((x1 - x0) * (y1 - y0));
+    double cs = 1 / (255 * area);
+    return PixelRGBA32F(static_cast<float>(sum(&Cell::r) * cs), static_cast<float>(sum(&Cell::g) * cs),
+                        static_cast<float>(sum(&Cell::b) * cs), static_cast<float>(sum(&Cell::a) / area));
+}
+
+template<typename Accum>
+inline aut::PixelRGBA aut::SummedAreaTable<Accum>::Average(Rect2D rect) const {
+    return detail::Unpremultiply(AveragePremultiplied(rect));
+}
+
+template<typename Accum>
+inline aut::PixelRGBA aut::SummedAreaTable<Accum>::Average(int x, int y, int radius) const {
+    radius = std::max(radius, 0);
+    unsigned int d = static_cast<unsigned int>(radius) * 2 + 1;
+    return Average(Rect2D(x - radius, y - radius, d, d));
+}
+
+template<typename Accum>
+inline void aut::BoxBlurVariable(PixelRGBA *dst, const SummedAreaTable<Accum> &sat, const float *radius) {
+    Size2D size = sat.GetSize();
+    // 画像より大きい半径は結果が変わらないので、intへのキャストが溢れないようにここで止める
+    const float max_radius = static_cast<float>(std::max(size.w, size.h));
+    ParallelFor(0, size.h, [&](size_t y) {
+        const float *rad = radius + y * size.w;
+        PixelRGBA *out = dst + y * size.w;
+        int iy = static_cast<int>(y);
+        for (unsigned int x = 0; x < size.w; x++) {
+            float r = rad[x];
+            if (!(r > 0))
+                r = 0;
+            else if (r > max_radius)
+                r = max_radius;
+            int r0 = static_cast<int>(r);
+            float t = r - r0;
+            unsigned int d = static_cast<unsigned int>(r0) * 2 + 1;
+            int ix = static_cast<int>(x);
+            PixelRGBA32F c = sat.AveragePremultiplied(Rect2D(ix - r0, iy - r0, d, d));
+            if (t > 0) {
+                PixelRGBA32F c1 = sat.AveragePremultiplied(Rect2D(ix - r0 - 1, iy - r0 - 1, d + 2, d + 2));
+                c = PixelRGBA32F(c.r + (c1.r - c.r) * t, c.g + (c1.g - c.g) * t,
+                                 c.b + (c1.b - c.b) * t, c.a + (c1.a - c.a) * t);
+            }
+            out[x] = detail::Unpremultiply(c);
+        }
+    }, 4);
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_SUMMEDAREA_H_
@@ -0,0 +1,255 @@
+/**
+ * @file AUL_TimelineSampler.h
+ * @author SEED264
+ * @brief Batched obj.getvalue sampling
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_TIMELINESAMPLER_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_TIMELINESAMPLER_H_
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <lua.hpp>
+#include "./AUL_Wrapper.h"
+
+namespace aut {
+    /**
+     * Sample several obj.getvalue targets at several times in one pass
+     *
+     * obj.getvalue is looked up once per call and the target names are
+     * kept in a registry table, so each value costs only the call itself.
+     * Repeated times in one Sample call query the host only once. Caching
+     * across calls is off by default, because obj.layer, obj.index and
+     * obj.frame do not change when the user edits a track bar and the
+     * cached values would go stale.
+     */
+    class TimelineSampler {
+    public:
+        TimelineSampler();
+        TimelineSampler(const TimelineSampler&) = delete;
+        TimelineSampler& operator=(const TimelineSampler&) = delete;
+
+        /**
+         * Add a setting type such as "x", "zoom", "rz", "alpha" or "layer2.x"
+         *
+         * @return size_t Column of the target in results
+         */
+        size_t AddTarget(std::string_view name);
+        /**
+         * Add a track bar by its number (0 = first track bar)
+         *
+         * @return size_t Column of the target in results
+         */
+        size_t AddTarget(int track);
+        void ClearTargets();
+        size_t TargetCount() const;
+
+        /**
+         * Get every target at every time
+         *
+         * @param[in] times Times passed to obj.getvalue (seconds from the object start)
+         * @param[in] count Number of times
+         *
+         * @return const std::vector<lua_Number>& Matrix of count rows and
+         *         TargetCount() columns, valid until the next call
+         */
+        const std::vector<lua_Number>& Sample(lua_State *L, const double *times, size_t count);
+        /**
+         * Get a value of the last result
+         */
+        lua_Number At(size_t time_index, size_t target_index) const;
+        /**
+         * Drop the cached values (e.g. after changing settings of the object)
+         */
+        void Invalidate();
+        /**
+         * Keep the cached values between Sample calls while obj.layer,
+         * obj.index and obj.frame stay the same (default: false)
+         *
+         * Only enable this when the settings cannot change between the calls,
+         * e.g. several passes inside one script run, and call Invalidate()
+         * at the start of each run.
+         */
+        void SetCacheAcrossCalls(bool enable);
+        /**
+         * Remove the target table from the registry of L
+         */
+        void Release(lua_State *L);
+
+    private:
+        struct Target {
+            std::string name;
+            int track;
+        };
+        // キャッシュが有効なオブジェクトとフレーム
+        struct FrameKey {
+            lua_Integer layer, index, frame;
+
+            bool operator==(const FrameKey &other) const {
+                return layer == other.layer && index == other.index && frame == other.frame;
+            }
+        };
+
+        void PushTargets(lua_State *L);
+        FrameKey ReadFrameKey(lua_State *L, int obj_index) const;
+
+        std::vector<Target> targets_;
+        bool targets_dirty_;
+        bool cache_valid_;
+        bool cache_across_calls_;
+        FrameKey cache_key_;
+        // 時刻から値の行 (cache_values_の先頭位置) への対応
+        std::map<double, size_t> cache_rows_;
+        std::vector<lua_Number> cache_values_;
+        std::vector<lua_Number> result_;
+    };
+}
+
+inline aut::TimelineSampler::TimelineSampler()
+    : targets_dirty_(true), cache_valid_(false), cache_across_calls_(false), cache_key_() {}
+
+inline size_t aut::TimelineSampler::AddTarget(std::string_view name) {
+    targets_.push_back(Target{ std::string(name), -1 });
+    targets_dirty_ = true;
+    Invalidate();
+    return targets_.size() - 1;
+}
+
+inline size_t aut::TimelineSampler::AddTarget(int track) {
+    targets_.push_back(Target{ std::string(), track });
+    targets_dirty_ = true;
+    Invalidate();
+    return targets_.size() - 1;
+}
+
+inline void aut::TimelineSampler::ClearTargets() {
+    targets_.clear();
+    targets_dirty_ = true;
+    Invalidate();
+}
+
+inline size_t aut::TimelineSampler::TargetCount() const {
+    return targets_.size();
+}
+
+inline const std::vector<lua_Number>& aut::TimelineSampler::Sample(lua_State *L, const double *times,
+                                                                   size_t count) {
+    size_t n = targets_.size();
+    result_.resize(count * n);
+    if (count == 0 || n == 0)return result_;
+    GetAULFunc(L, "getvalue");
+    int obj_index = lua_gettop(L) - 1;
+    FrameKey key = ReadFrameKey(L, obj_index);
+    if (!cache_across_calls_ || !cache_valid_ || !(key == cache_key_)) {
+        cache_rows_.clear();
+        cache_values_.clear();
+        cache_key_ = key;
+        cache_valid_ = true;
+    }
+    PushTargets(L);
+    for (size_t t = 0; t < count; t++) {
+        auto it = cache_rows_.find(times[t]);
+        if (it == cache_rows_.end()) {
+            size_t row = cache_values_.size();
+            cache_values_.resize(row + n);
+            for (size_t i = 0; i < n; i++) {
+                lua_pushvalue(L, -2);
+                lua_rawgeti(L, -2, static_cast<int>(i + 1));
+                lua_pushnumber(L, times[t]);
+                lua_call(L, 2, 1);
+                cache_values_[row + i] = lua_tonumber(L, -1);
+                lua_pop(L, 1);
+            }
+            it = cache_rows_.emplace(times[t], row).first;
+        }
+        std::copy(cache_values_.begin() + it->second, cache_values_.begin() + it->second + n,
+                  result_.begin() + t * n);
+    }
+    lua_pop(L, 3);
+    return result_;
+}
+
+inline lua_Number aut::TimelineSampler::At(size_t time_index, size_t target_index) const {
+    return result_[time_index * targets_.size() + target_index];
+}
+
+inline void aut::TimelineSampler::Invalidate() {
+    cache_valid_ = false;
+    cache_rows_.clear();
+    cache_values_.clear();
+}
+
+inline void aut::TimelineSampler::SetCacheAcrossCalls(bool enable) {
+    cache_across_calls_ = enable;
+    Invalidate();
+}
+
+inline void aut::TimelineSampler::Release(lua_State *L) {
+    lua_pushlightuserdata(L, this);
+    lua_pushnil(L);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+    targets_dirty_ = true;
+}
+
+inline void aut::TimelineSampler::PushTargets(lua_State *L) {
+    // 対象の名前 (またはトラックバー番号) の配列をレジストリに置いておく
+    lua_pushlightuserdata(L, this);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+    if (!targets_dirty_ && lua_type(L, -1) == LUA_TTABLE)return;
+    lua_pop(L, 1);
+    lua_createtable(L, static_cast<int>(targets_.size()), 0);
+    for (size_t i = 0; i < targets_.size(); i++) {
+        if (targets_[i].track >= 0)
+            lua_pushinteger(L, targets_[i].track);
+        else
+            lua_pushlstring(L, targets_[i].name.data(), targets_[i].name.size());
+        lua_rawseti(L, -2, static_cast<int>(i + 1));
+    }
+    lua_pushlightuserdata(L, this);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+    targets_dirty_ = false;
+}
+
+inline aut::TimelineSampler::FrameKey aut::TimelineSampler::ReadFrameKey(lua_State *L, int obj_index) const {
+    FrameKey key;
+    lua_getfield(L, obj_index, "layer");
+    key.layer = lua_tointeger(L, -1);
+    lua_getfield(L, obj_index, "index");
+    key.index = lua_tointeger(L, -1);
+    lua_getfield(L, obj_index, "frame");
+    key.frame = lua_tointeger(L, -1);
+    lua_pop(L, 3);
+    return key;
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_TIMELINESAMPLER_H_
@@ -45,6 +45,45 @@ namespace aut{
         PixelRGBA() : PixelRGBA(0, 0, 0, 0) {}
     };
 
+    // チャンネル16bitの画素用の構造体
+    // PixelRGBAと同じくメモリ上の順番はBGRA
+    struct PixelRGBA16 {
+        unsigned short b;
+        unsigned short g;
+        unsigned short r;
+        unsigned short a;
+
+        PixelRGBA16(unsigned short ar, unsigned short ag, unsigned short ab, unsigned short aa) :
+            b(ab), g(ag), r(ar), a(aa) {}
+        PixelRGBA16() : PixelRGBA16(0, 0, 0, 0) {}
+    };
+
+    // チャンネル32bit浮動小数点数の画素用の構造体
+    // PixelRGBAと同じくメモリ上の順番はBGRA
+    struct PixelRGBA32F {
+        float b;
+        float g;
+        float r;
+        float a;
+
+        PixelRGBA32F(float ar, float ag, float ab, float aa) :
+            b(ab), g(ag), r(ar), a(aa) {}
+        PixelRGBA32F() : PixelRGBA32F(0, 0, 0, 0) {}
+    };
+
+    // チャンネル16bit浮動小数点数(half)の画素用の構造体
+    // 各チャンネルはhalfのビット列をそのまま保持する
+    struct PixelRGBA16F {
+        unsigned short b;
+        unsigned short g;
+        unsigned short r;
+        unsigned short a;
+
+        PixelRGBA16F(unsigned short ar, unsigned short ag, unsigned short ab, unsigned short aa) :
+            b(ab), g(ag), r(ar), a(aa) {}
+        PixelRGBA16F() : PixelRGBA16F(0, 0, 0, 0) {}
+    };
+
     // 画像のサイズ等に使う構造体
     struct Size2D{
         unsigned int w, h;
@@ -57,6 +96,20 @@ namespace aut{
         }
     };
 
+    // 画像内の矩形領域に使う構造体
+    struct Rect2D {
+        int x, y;
+        unsigned int w, h;
+
+        Rect2D(int ax, int ay, unsigned int aw, unsigned int ah)
+            : x(ax), y(ay), w(aw), h(ah) {}
+        Rect2D() : Rect2D(0, 0, 0, 0) {}
+
+        unsigned int Area() const {
+            return w * h;
+        }
+    };
+
     // カメラのパラメータ用の構造体
     struct CameraParam {
         double  x,  y,  z;
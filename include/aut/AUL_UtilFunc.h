@@ -30,9 +30,12 @@
 #define _USE_MATH_DEFINES
 #define NOMINMAX
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <Windows.h>
 #include <glm/vec2.hpp>
@@ -118,23 +121,19 @@ namespace aut {
     // スタックトップに文字列を積む関数
     size_t PushValue(lua_State *L, const std::string &v);
     // スタックトップに文字列を積む関数
+    size_t PushValue(lua_State *L, std::string_view v);
+    // スタックトップに文字列を積む関数
     size_t PushValue(lua_State *L, const char *v);
     // スタックトップに浮動小数点数を積む関数
     size_t PushValue(lua_State *L, lua_Number v);
     // スタックトップにbool値を積む関数
     size_t pushBool(lua_State *L, bool v);
 
-    // スタックトップに引数を積む関数
-    // 実際に積んだ引数の数を返す
-    size_t SetArgs(lua_State *L);
-    // スタックトップに引数を積む関数
-    // 実際に積んだ引数の数を返す
-    template <typename T>
-    size_t SetArgs(lua_State *L, T value);
-    // スタックトップに引数を積む関数
-    // 実際に積んだ引数の数を返す
-    template <typename T, typename... Parms>
-    size_t SetArgs(lua_State *L, T value, Parms... parms);
+    // スタックトップに引数を左から順に積む関数
+    // 引数はコピーせずにそのまま各PushValueへ渡す
+    // PushValueはどれも値を1個だけ積むので、積んだ数として引数の数をコンパイル時に返す
+    template <typename... Params>
+    size_t SetArgs(lua_State *L, Params&&... params);
 
     // 指定したテーブルの内容をbool値としてvectorにコピーする関数
     std::vector<bool> ToArrayBoolean(lua_State *L, int table_index = -1);
@@ -155,10 +154,35 @@ namespace aut {
     std::vector<std::string> ToArrayString(lua_State *L, const std::string &name);
 
     // 指定した名前のテーブルの内容をdvec2としてvectorにコピーする関数
+    // 最大max_num個まで読み込む
     std::vector<glm::dvec2> TableToVec2(lua_State *L, const std::string &table_name, int max_num = INT_MAX);
     // 指定した名前のテーブルの内容をdvec3としてvectorにコピーする関数
+    // 最大max_num個まで読み込む
     std::vector<glm::dvec3> TableToVec3(lua_State *L, const std::string &table_name, int max_num = INT_MAX);
 
+    // 指定した平坦なテーブル{x1, y1, x2, y2, ...}に含まれるcomponents次元のベクトルの数を返す関数
+    size_t VectorArrayCount(lua_State *L, size_t components, int table_index = -1);
+    // 指定した平坦なテーブルからcomponents次元のベクトルを最大max_num個読み込む関数
+    // i番目のベクトルのj番目の成分はout[i * stride + j]に書き込み、足りない成分は0になる
+    // 読み込んだベクトルの数を返す
+    template<typename T>
+    size_t ReadVectorArray(lua_State *L, size_t components, T *out, size_t stride, size_t max_num,
+                           int table_index = -1);
+    // 指定した平坦なテーブルからcomponents次元のベクトルを成分毎の配列に最大max_num個読み込む関数
+    // i番目のベクトルのj番目の成分はplanes[j][i]に書き込む
+    // 読み込んだベクトルの数を返す
+    template<typename T>
+    size_t ReadVectorArraySoA(lua_State *L, size_t components, T *const *planes, size_t max_num,
+                              int table_index = -1);
+    // スタックトップにcount個のベクトルを平坦なテーブル{x1, y1, x2, y2, ...}として作成する関数
+    // i番目のベクトルのj番目の成分はdata[i * stride + j]から読む
+    template<typename T>
+    void PushVectorArray(lua_State *L, size_t components, const T *data, size_t stride, size_t count);
+    // スタックトップにdvec2の配列を平坦なテーブルとして作成する関数
+    void PushArrayVec2(lua_State *L, const glm::dvec2 *data, size_t count);
+    // スタックトップにdvec3の配列を平坦なテーブルとして作成する関数
+    void PushArrayVec3(lua_State *L, const glm::dvec3 *data, size_t count);
+
     // 引数の値を文字列として結合する関数
     template <typename T>
     std::string CombineAsString(T value);
@@ -392,7 +416,12 @@ inline size_t aut::PushValue(lua_State *L, unsigned long v) {
 }
 
 inline size_t aut::PushValue(lua_State *L, const std::string &v) {
-    lua_pushstring(L, v.c_str());
+    lua_pushlstring(L, v.data(), v.size());
+    return 1;
+}
+
+inline size_t aut::PushValue(lua_State *L, std::string_view v) {
+    lua_pushlstring(L, v.data(), v.size());
     return 1;
 }
 
@@ -411,19 +440,13 @@ inline size_t aut::pushBool(lua_State *L, bool v) {
     return 1;
 }
 
-inline size_t aut::SetArgs(lua_State *L) {
-    return 0;
-}
-
-template <typename T>
-inline size_t aut::SetArgs(lua_State *L, T value) {
-    return aut::PushValue(L, value);
-}
-
-template <typename T, typename... Parms>
-inline size_t aut::SetArgs(lua_State *L, T value, Parms... parms) {
-    size_t pushed_num = aut::PushValue(L, value);
-    return SetArgs(L, parms...) + pushed_num;
+template <typename... Params>
+inline size_t aut::SetArgs(lua_State *L, Params&&... params) {
+    // 引数が空のときはLを使わないので警告を抑える
+    (void)L;
+    // カンマ演算子の畳み込みは左から順に評価される
+    (static_cast<void>(aut::PushValue(L, std::forward<Params>(params))), ...);
+    return sizeof...(Params);
 }
 
 inline std::vector<bool> aut::ToArrayBoolean(lua_State *L, int table_index) {
@@ -518,19 +541,11 @@ inline std::vector<glm::dvec2> aut::TableToVec2(lua_State *L, const std::string
     std::vector<glm::dvec2> out_vec;
     auto v_status = GetVariable(L, table_name);
     if (v_status != kAutLuaVarNotFound) {
-        size_t t_len = lua_objlen(L, -1);
-        out_vec.resize(static_cast<size_t>(std::ceil(static_cast<double>(t_len) / 2)));
-        for (size_t i = 0; i < out_vec.size(); i++) {
-            glm::dvec2 v;
-            for(size_t j = 0; j < 2; j++) {
-                size_t index = 2 * i + j + 1;
-                if (index > t_len)break;
-                v[j] = GetTableNumber(L, index);
-            }
-            out_vec[i] = v;
-        }
+        size_t num = std::min(VectorArrayCount(L, 2), static_cast<size_t>(std::max(max_num, 0)));
+        out_vec.resize(num);
+        ReadVectorArray(L, 2, reinterpret_cast<double*>(out_vec.data()), 2, num);
+        lua_pop(L, 1);
     }
-    lua_pop(L, 1);
     return out_vec;
 }
 
@@ -538,20 +553,81 @@ inline std::vector<glm::dvec3> aut::TableToVec3(lua_State *L, const std::string
     std::vector<glm::dvec3> out_vec;
     auto v_status = GetVariable(L, table_name);
     if (v_status != kAutLuaVarNotFound) {
-        size_t t_len = lua_objlen(L, -1);
-        out_vec.resize(static_cast<size_t>(std::ceil(static_cast<double>(t_len) / 3)));
-        for (size_t i = 0; i < out_vec.size(); i++) {
-            glm::dvec3 v;
-            for(size_t j = 0; j < 3; j++) {
-                size_t index = 3 * i + j + 1;
-                if (index > t_len)break;
-                v[j] = GetTableNumber(L, index);
+        size_t num = std::min(VectorArrayCount(L, 3), static_cast<size_t>(std::max(max_num, 0)));
+        out_vec.resize(num);
+        ReadVectorArray(L, 3, reinterpret_cast<double*>(out_vec.data()), 3, num);
+        lua_pop(L, 1);
+    }
+    return out_vec;
+}
+
+inline size_t aut::VectorArrayCount(lua_State *L, size_t components, int table_index) {
+    if (!lua_istable(L, table_index) || components == 0)return 0;
+    return (lua_objlen(L, table_index) + components - 1) / components;
+}
+
+template<typename T>
+inline size_t aut::ReadVectorArray(lua_State *L, size_t components, T *out, size_t stride, size_t max_num,
+                                   int table_index) {
+    size_t num = std::min(VectorArrayCount(L, components, table_index), max_num);
+    if (num == 0)return 0;
+    size_t t_len = lua_objlen(L, table_index);
+    // rawgetiで積んだ値はすぐに取り除くので、table_indexは相対位置のままで良い
+    for (size_t i = 0; i < num; i++) {
+        T *v = out + i * stride;
+        for (size_t j = 0; j < components; j++) {
+            size_t index = i * components + j + 1;
+            if (index > t_len) {
+                v[j] = 0;
+                continue;
             }
-            out_vec[i] = v;
+            lua_rawgeti(L, table_index, static_cast<int>(index));
+            v[j] = static_cast<T>(lua_tonumber(L, -1));
+            lua_pop(L, 1);
         }
     }
-    lua_pop(L, 1);
-    return out_vec;
+    return num;
+}
+
+template<typename T>
+inline size_t aut::ReadVectorArraySoA(lua_State *L, size_t components, T *const *planes, size_t max_num,
+                                      int table_index) {
+    size_t num = std::min(VectorArrayCount(L, components, table_index), max_num);
+    if (num == 0)return 0;
+    size_t t_len = lua_objlen(L, table_index);
+    for (size_t i = 0; i < num; i++) {
+        for (size_t j = 0; j < components; j++) {
+            size_t index = i * components + j + 1;
+            if (index > t_len) {
+                planes[j][i] = 0;
+                continue;
+            }
+            lua_rawgeti(L, table_index, static_cast<int>(index));
+            planes[j][i] = static_cast<T>(lua_tonumber(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+    return num;
+}
+
+template<typename T>
+inline void aut::PushVectorArray(lua_State *L, size_t components, const T *data, size_t stride, size_t count) {
+    lua_createtable(L, static_cast<int>(count * components), 0);
+    for (size_t i = 0; i < count; i++) {
+        const T *v = data + i * stride;
+        for (size_t j = 0; j < components; j++) {
+            lua_pushnumber(L, static_cast<lua_Number>(v[j]));
+            lua_rawseti(L, -2, static_cast<int>(i * components + j + 1));
+        }
+    }
+}
+
+inline void aut::PushArrayVec2(lua_State *L, const glm::dvec2 *data, size_t count) {
+    PushVectorArray(L, 2, reinterpret_cast<const double*>(data), 2, count);
+}
+
+inline void aut::PushArrayVec3(lua_State *L, const glm::dvec3 *data, size_t count) {
+    PushVectorArray(L, 3, reinterpret_cast<const double*>(data), 3, count);
 }
 
 template <typename T>
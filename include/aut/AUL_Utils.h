@@ -31,5 +31,33 @@
 #include "./AUL_Type.h"
 #include "./AUL_UtilFunc.h"
 #include "./AUL_Wrapper.h"
+#include "./AUL_Simd.h"
+#include "./AUL_Random.h"
+#include "./AUL_Parallel.h"
+#include "./AUL_Noise.h"
+#include "./AUL_Hash.h"
+#include "./AUL_PixelBuffer.h"
+#include "./AUL_Memory.h"
+#include "./AUL_ImagePool.h"
+#include "./AUL_Image.h"
+#include "./AUL_ColorSpace.h"
+#include "./AUL_Blend.h"
+#include "./AUL_Sampling.h"
+#include "./AUL_Warp.h"
+#include "./AUL_Mipmap.h"
+#include "./AUL_SummedArea.h"
+#include "./AUL_Distance.h"
+#include "./AUL_Morphology.h"
+#include "./AUL_Statistics.h"
+#include "./AUL_Binding.h"
+#include "./AUL_NativeArray.h"
+#include "./AUL_Ffi.h"
+#include "./AUL_Precompute.h"
+#include "./AUL_Proxy.h"
+#include "./AUL_Particles.h"
+#include "./AUL_SpatialHash.h"
+#include "./AUL_TimelineSampler.h"
+#include "./AUL_Accumulation.h"
+#include "./AUL_Raster.h"
 
 #endif // _AUL_UTILS_INCLUDE_AUT_AUL_UTILS_H_
\ No newline at end of file
@@ -0,0 +1,213 @@
+/**
+ * @file AUL_Warp.h
+ * @author SEED264
+ * @brief Affine and perspective warp of pixel buffers
+ */
+
+/*
+ * This file is part of AUL_Utils.
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2021 SEED264
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _AUL_UTILS_INCLUDE_AUT_AUL_WARP_H_
+#define _AUL_UTILS_INCLUDE_AUT_AUL_WARP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/matrix.hpp>
+#include "./AUL_Enum.h"
+#include "./AUL_Mipmap.h"
+#include "./AUL_Parallel.h"
+#include "./AUL_Sampling.h"
+#include "./AUL_Type.h"
+#include "./AUL_UtilFunc.h"
+
+namespace aut {
+    /**
+     * Make a matrix that scales and rotates around center, then translates
+     *
+     * @param[in] center Center of the scale and rotation (source pixel coords)
+     * @param[in] scale Enlargement rate (1.0 = 1x)
+     * @param[in] rot Rotation angle (one rotation at 360.0)
+     * @param[in] translate Position of center after the transform
+     *
+     * @return glm::dmat3 Transform from source coords to destination coords
+     */
+    glm::dmat3 AffineMatrix(glm::dvec2 center, glm::dvec2 scale, double rot, glm::dvec2 translate);
+    /**
+     * Make a matrix that maps the quad src onto the quad dst (corner pin)
+     * Vertices are in the same order as obj.drawpoly.
+     *
+     * @param[in] src Vertices 0 ~ 3 of the source quad
+     * @param[in] dst Vertices 0 ~ 3 of the destination quad
+     *
+     * @return glm::dmat3 Transform from source coords to destination coords
+     */
+    glm::dmat3 PerspectiveMatrix(const glm::dvec2 (&src)[4], const glm::dvec2 (&dst)[4]);
+    /**
+     * Warp src into dst
+     * Every pixel of dst is overwritten with src sampled at the inverse
+     * transform of the pixel center. The source coords are stepped along each
+     * row instead of multiplying the matrix per pixel, and 64x64 tiles are
+     * processed in parallel.
+     *
+     * @param[out] dst Destination pixels
+     * @param[in] dst_size Destination size
+     * @param[in] src Source pixels
+     * @param[in] src_size Source size
+     * @param[in] matrix Transform from source coords to destination coords
+     * @param[in] address Addressing mode outside the source
+     * @param[in] filter Filter mode
+     */
+    void Warp(PixelRGBA *dst, Size2D dst_size, const PixelRGBA *src, Size2D src_size,
+              const glm::dmat3 &matrix, SamplingAddressMode address = kAutAddressBorder,
+              SamplingFilterMode filter = kAutFilterLinear);
+
+    /**
+     * Warp a mipmap into dst
+     * With kAutFilterTrilinear the level is chosen per pixel from the
+     * footprint of the transform, so minified results do not alias.
+     *
+     * @param[out] dst Destination pixels
+     * @param[in] dst_size Destination size
+     * @param[in] src Source pyramid
+     * @param[in] matrix Transform from source coords to destination coords
+     * @param[in] address Addressing mode outside the source
+     * @param[in] filter Filter mode
+     */
+    void Warp(PixelRGBA *dst, Size2D dst_size, const Mipmap &src, const glm::dmat3 &matrix,
+              SamplingAddressMode address = kAutAddressBorder,
+              SamplingFilterMode filter = kAutFilterTrilinear);
+
+    namespace detail {
+        // 単位正方形から四角形への射影変換
+        glm::dmat3 SquareToQuad(const glm::dvec2 (&q)[4]);
+        // sample(u, v, footprint)で乗算済みの色を得る
+        // Footprintがfalseの時はfootprintを計算しない
+        template<bool Footprint, typename Sampler>
+        void WarpTiles(PixelRGBA *dst, Size2D dst_size, const glm::dmat3 &inv, Sampler sample);
+    }
+}
+
+inline glm::dmat3 aut::AffineMatrix(glm::dvec2 center, glm::dvec2 scale, double rot, glm::dvec2 translate) {
+    double rad = ToRadian(rot);
+    double c = std::cos(rad), s = std::sin(rad);
+    // p' = R * S * (p - center) + translate
+    double a = c * scale.x, b = -s * scale.y;
+    double d = s * scale.x, e = c * scale.y;
+    double tx = translate.x - (a * center.x + b * center.y);
+    double ty = translate.y - (d * center.x + e * center.y);
+    return glm::dmat3(a, d, 0, b, e, 0, tx, ty, 1);
+}
+
+inline glm::dmat3 aut::detail::SquareToQuad(const glm::dvec2 (&q)[4]) {
+    double sx = q[0].x - q[1].x + q[2].x - q[3].x;
+    double sy = q[0].y - q[1].y + q[2].y - q[3].y;
+    double g = 0, h = 0;
+    if (sx != 0 || sy != 0) {
+        double dx1 = q[1].x - q[2].x, dx2 = q[3].x - q[2].x;
+        double dy1 = q[1].y - q[2].y, dy2 = q[3].y - q[2].y;
+        double den = dx1 * dy2 - dx2 * dy1;
+        if (den != 0) {
+            g = (sx * dy2 - dx2 * sy) / den;
+            h = (dx1 * sy - sx * dy1) / den;
+        }
+    }
+    double a = q[1].x - q[0].x + g * q[1].x, b = q[3].x - q[0].x + h * q[3].x;
+    double d = q[1].y - q[0].y + g * q[1].y, e = q[3].y - q[0].y + h * q[3].y;
+    return glm::dmat3(a, d, g, b, e, h, q[0].x, q[0].y, 1);
+}
+
+inline glm::dmat3 aut::PerspectiveMatrix(const glm::dvec2 (&src)[4], const glm::dvec2 (&dst)[4]) {
+    return detail::SquareToQuad(dst) * glm::inverse(detail::SquareToQuad(src));
+}
+
+template<bool Footprint, typename Sampler>
+inline void aut::detail::WarpTiles(PixelRGBA *dst, Size2D dst_size, const glm::dmat3 &inv, Sampler sample) {
+    const unsigned int kTile = 64;
+    const unsigned int tile_w = (dst_size.w + kTile - 1) / kTile;
+    const unsigned int tile_h = (dst_size.h + kTile - 1) / kTile;
+    const bool affine = inv[0].z == 0 && inv[1].z == 0 && inv[2].z == 1;
+    const glm::dvec3 step = inv[0], step_y = inv[1];
+    ParallelFor(0, static_cast<size_t>(tile_w) * tile_h, [&](size_t tile) {
+        unsigned int x0 = static_cast<unsigned int>(tile % tile_w) * kTile;
+        unsigned int y0 = static_cast<unsigned int>(tile / tile_w) * kTile;
+        unsigned int x1 = std::min(x0 + kTile, dst_size.w), y1 = std::min(y0 + kTile, dst_size.h);
+        for (unsigned int y = y0; y < y1; y++) {
+            glm::dvec3 p = inv * glm::dvec3(x0 + 0.5, y + 0.5, 1);
+            PixelRGBA *row = dst + static_cast<size_t>(y) * dst_size.w;
+            for (unsigned int x = x0; x < x1; x++, p.x += step.x, p.y += step.y, p.z += step.z) {
+                double u, v, rz = 1;
+                if (affine) {
+                    u = p.x;
+                    v = p.y;
+                } else if (p.z > 0) {
+                    rz = 1 / p.z;
+                    u = p.x * rz;
+                    v = p.y * rz;
+                } else {
+                    // 視点の後ろ側
+                    row[x] = PixelRGBA();
+                    continue;
+                }
+                float footprint = 1;
+                if (Footprint) {
+                    // 出力の1画素あたりのソース座標の変化量 (ヤコビアン)
+                    double ux = (step.x - u * step.z) * rz, vx = (step.y - v * step.z) * rz;
+                    double uy = (step_y.x - u * step_y.z) * rz, vy = (step_y.y - v * step_y.z) * rz;
+                    footprint = static_cast<float>(std::sqrt(std::max(ux * ux + vx * vx, uy * uy + vy * vy)));
+                }
+                row[x] = Unpremultiply(sample(static_cast<float>(u), static_cast<float>(v), footprint));
+            }
+        }
+    });
+}
+
+inline void aut::Warp(PixelRGBA *dst, Size2D dst_size, const PixelRGBA *src, Size2D src_size,
+                      const glm::dmat3 &matrix, SamplingAddressMode address,
+                      SamplingFilterMode filter) {
+    glm::dmat3 inv = glm::inverse(matrix);
+    detail::DispatchSampling(address, filter, [&](auto a, auto f) {
+        detail::WarpTiles<false>(dst, dst_size, inv, [&](float u, float v, float) {
+            return detail::SamplePremultiplied<decltype(a)::value, decltype(f)::value>(src, src_size, u, v);
+        });
+    });
+}
+
+inline void aut::Warp(PixelRGBA *dst, Size2D dst_size, const Mipmap &src, const glm::dmat3 &matrix,
+                      SamplingAddressMode address, SamplingFilterMode filter) {
+    glm::dmat3 inv = glm::inverse(matrix);
+    detail::DispatchSampling(address, filter, [&](auto a, auto f) {
+        detail::WarpTiles<decltype(f)::value == kAutFilterTrilinear>(dst, dst_size, inv,
+                                                                       [&](float u, float v, float footprint) {
+            return detail::SampleMipmapPremultiplied<decltype(a)::value, decltype(f)::value>(src, u, v, footprint);
+        });
+    });
+}
+
+#endif // _AUL_UTILS_INCLUDE_AUT_AUL_WARP_H_
@@ -36,15 +36,24 @@
 #include <cstddef>
 #include <limits>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <lua.hpp>
+#include "./AUL_Binding.h"
 #include "./AUL_Enum.h"
 #include "./AUL_Type.h"
 #include "./AUL_UtilFunc.h"
 
 namespace aut {
+    /**
+     * Stack functions in obj space on the top of the stack
+     * 
+     * @param[in] func_name The name of the function that want to get
+     */
+    void GetAULFunc(lua_State *L, const char *func_name);
     /**
      * Stack functions in obj space on the top of the stack
      * 
@@ -58,7 +67,7 @@ namespace aut {
      * @param[in] params Similar to obj.effect
      */
     template <typename... Params>
-    void effect(lua_State *L, Params... params);
+    void effect(lua_State *L, Params&&... params);
     /**
      * Call obj.draw
      * 
@@ -133,7 +142,7 @@ namespace aut {
      * @param params Similar to obj.load
      */
     template <typename... Params>
-    void load(lua_State *L, Params... params);
+    void load(lua_State *L, Params&&... params);
     /**
      * Call obj.setfont
      * @param[in] name Font name
@@ -141,7 +150,7 @@ namespace aut {
      * @param[in] params Similar to obj.setfont
      */
     template <typename... Params>
-    void setfont(lua_State *L, const std::string &name, double size, Params... params);
+    void setfont(lua_State *L, std::string_view name, double size, Params&&... params);
     /**
      * Call obj.rand
      * 
@@ -152,7 +161,7 @@ namespace aut {
      * @return lua_Integer Generated random number (integer)
      */
     template <typename... Params>
-    lua_Integer rand(lua_State *L, lua_Integer st_num, lua_Integer ed_num, Params... params);
+    lua_Integer rand(lua_State *L, lua_Integer st_num, lua_Integer ed_num, Params&&... params);
     /**
      * Call obj.setoption
      * 
@@ -160,7 +169,7 @@ namespace aut {
      * @param[in] params Similar to obj.setoption
      */
     template <typename... Params>
-    void setoption(lua_State *L, const std::string &name, Params... params);
+    void setoption(lua_State *L, std::string_view name, Params&&... params);
     /**
      * Call obj.getoption("track_mode", ...)
      * 
@@ -218,7 +227,7 @@ namespace aut {
      * @return lua_Number Current object's setting value
      */
     template<typename T, typename... Params>
-    lua_Number getvalue(lua_State *L, T target, Params... params);
+    lua_Number getvalue(lua_State *L, T &&target, Params&&... params);
     /**
      * Call obj.setanchor
      * 
@@ -232,8 +241,8 @@ namespace aut {
      * @return lua_Integer Number of anchor points acquired
      */
     template<typename... Params>
-    lua_Integer setanchor(lua_State *L, const std::string &name, lua_Integer num,
-                          Params... params);
+    lua_Integer setanchor(lua_State *L, std::string_view name, lua_Integer num,
+                          Params&&... params);
     /**
      * Call obj.getaudio
      * 
@@ -260,7 +269,7 @@ namespace aut {
      * @param[in] params Similar to obj.filter
      */
     template<typename... Params>
-    void filter(lua_State *L, const std::string &name, Params... params);
+    void filter(lua_State *L, std::string_view name, Params&&... params);
     /**
      * Call obj.copybuffer
      * 
@@ -269,7 +278,7 @@ namespace aut {
      * 
      * @return bool true = success / false = failure
      */
-    bool copybuffer(lua_State *L, const std::string &dst, const std::string &src);
+    bool copybuffer(lua_State *L, std::string_view dst, std::string_view src);
     /**
      * Call obj.getpixel(x,y, "col")
      * 
@@ -335,14 +344,14 @@ namespace aut {
      * @param[in] name Option name
      * @param[in] value Option value
      */
-    void pixeloption(lua_State *L, const std::string &name, const std::string &value);
+    void pixeloption(lua_State *L, std::string_view name, std::string_view value);
     /**
      * Call obj.pixeloption
      * 
      * @param[in] name Option name
      * @param[in] value Option value
      */
-    void pixeloption(lua_State *L, const std::string &name, lua_Integer value);
+    void pixeloption(lua_State *L, std::string_view name, lua_Integer value);
     /**
      * Call obj.getpixeldata
      * 
@@ -351,7 +360,7 @@ namespace aut {
      * @param[in] params Similar to obj.getpixeldata
      */
     template<typename... Params>
-    void getpixeldata(lua_State *L, PixelRGBA **out_data, Size2D *out_size, Params... params);
+    void getpixeldata(lua_State *L, PixelRGBA **out_data, Size2D *out_size, Params&&... params);
     /**
      * Call obj.getpixeldata
      * 
@@ -361,7 +370,7 @@ namespace aut {
      * @param[in] params Similar to obj.getpixeldata
      */
     template<typename... Params>
-    void getpixeldata(lua_State *L, PixelRGBA **out_data, uint *out_w, uint *out_h, Params... params);
+    void getpixeldata(lua_State *L, PixelRGBA **out_data, uint *out_w, uint *out_h, Params&&... params);
     /**
      * Call obj.putpixeldata
      * 
@@ -452,15 +461,19 @@ namespace aut {
                              const glm::dvec3 &p2, const glm::dvec3 &p3);
 }
 
-inline void aut::GetAULFunc(lua_State *L, const std::string &func_name) {
+inline void aut::GetAULFunc(lua_State *L, const char *func_name) {
     lua_getglobal(L, "obj");
-    lua_getfield(L, -1, func_name.c_str());
+    lua_getfield(L, -1, func_name);
+}
+
+inline void aut::GetAULFunc(lua_State *L, const std::string &func_name) {
+    GetAULFunc(L, func_name.c_str());
 }
 
 template <typename... Params>
-inline void aut::effect(lua_State *L, Params... params) {
+inline void aut::effect(lua_State *L, Params&&... params) {
     aut::GetAULFunc(L, "effect");
-    size_t pushed_num = SetArgs(L, params...);
+    size_t pushed_num = SetArgs(L, std::forward<Params>(params)...);
     lua_call(L, pushed_num, 0);
     lua_pop(L, 1);
 }
@@ -507,27 +520,27 @@ inline void aut::drawpoly(lua_State *L,
 }
 
 template <typename... Params>
-inline void aut::load(lua_State *L, Params... params) {
+inline void aut::load(lua_State *L, Params&&... params) {
     aut::GetAULFunc(L, "load");
-    size_t pushed_num = SetArgs(L, params...);
+    size_t pushed_num = SetArgs(L, std::forward<Params>(params)...);
     lua_call(L, pushed_num, 0);
     lua_pop(L, 1);
 }
 
 template <typename... Params>
-inline void aut::setfont(lua_State *L, const std::string &name, double size,
-                         Params... params) {
+inline void aut::setfont(lua_State *L, std::string_view name, double size,
+                         Params&&... params) {
     aut::GetAULFunc(L, "setfont");
-    size_t pushed_num = SetArgs(L, name, size, params...);
+    size_t pushed_num = SetArgs(L, name, size, std::forward<Params>(params)...);
     lua_call(L, pushed_num, 0);
     lua_pop(L, 1);
 }
 
 template <typename... Params>
 inline lua_Integer aut::rand(lua_State *L, lua_Integer st_num, lua_Integer ed_num,
-                             Params... params) {
+                             Params&&... params) {
     GetAULFunc(L, "rand");
-    size_t pushed_num = SetArgs(L, st_num, ed_num, params...);
+    size_t pushed_num = SetArgs(L, st_num, ed_num, std::forward<Params>(params)...);
     lua_call(L, pushed_num, 1);
     lua_Integer ret = lua_tointeger(L, -1);
     lua_pop(L, 2);
@@ -535,9 +548,9 @@ inline lua_Integer aut::rand(lua_State *L, lua_Integer st_num, lua_Integer ed_nu
 }
 
 template <typename... Params>
-inline void aut::setoption(lua_State *L, const std::string &name, Params... params) {
+inline void aut::setoption(lua_State *L, std::string_view name, Params&&... params) {
     GetAULFunc(L, "setoption");
-    size_t pushed_num = SetArgs(L, name, params...);
+    size_t pushed_num = SetArgs(L, name, std::forward<Params>(params)...);
     lua_call(L, pushed_num, 0);
     lua_pop(L, 1);
 }
@@ -593,18 +606,9 @@ inline aut::CameraParam aut::getoption_camera_param(lua_State *L) {
     GetAULFunc(L, "getoption");
     size_t pushed_num = SetArgs(L, "camera_param");
     lua_call(L, pushed_num, 1);
-    CameraParam cp;
-    cp.x  = GetFieldNumber(L, "x");
-    cp.y  = GetFieldNumber(L, "y");
-    cp.z  = GetFieldNumber(L, "z");
-    cp.tx = GetFieldNumber(L, "tx");
-    cp.ty = GetFieldNumber(L, "ty");
-    cp.tz = GetFieldNumber(L, "tz");
-    cp.rz = GetFieldNumber(L, "rz");
-    cp.ux = GetFieldNumber(L, "ux");
-    cp.uy = GetFieldNumber(L, "uy");
-    cp.uz = GetFieldNumber(L, "uz");
-    cp.d  = GetFieldNumber(L, "d");
+    CameraParam cp{};
+    if (!ReadTable(L, -1, &cp))
+        luaL_error(L, "obj.getoption(\"camera_param\") did not return a table");
     lua_pop(L, 2);
     return cp;
 }
@@ -619,9 +623,9 @@ inline bool aut::getoption_multi_object(lua_State *L) {
 }
 
 template<typename T, typename... Params>
-inline lua_Number aut::getvalue(lua_State *L, T target, Params... params) {
+inline lua_Number aut::getvalue(lua_State *L, T &&target, Params&&... params) {
     GetAULFunc(L, "getvalue");
-    size_t pushed_num = SetArgs(L, target, params...);
+    size_t pushed_num = SetArgs(L, std::forward<T>(target), std::forward<Params>(params)...);
     lua_call(L, pushed_num, 1);
     lua_Number ret = lua_tonumber(L, -1);
     lua_pop(L, 2);
@@ -629,10 +633,10 @@ inline lua_Number aut::getvalue(lua_State *L, T target, Params... params) {
 }
 
 template<typename... Params>
-inline lua_Integer aut::setanchor(lua_State *L, const std::string &name,
-                                  lua_Integer num, Params... params) {
+inline lua_Integer aut::setanchor(lua_State *L, std::string_view name,
+                                  lua_Integer num, Params&&... params) {
     GetAULFunc(L, "setanchor");
-    size_t pushed_num = SetArgs(L, name, num, params...);
+    size_t pushed_num = SetArgs(L, name, num, std::forward<Params>(params)...);
     lua_call(L, pushed_num, 1);
     lua_Integer ret = lua_tointeger(L, -1);
     lua_pop(L, 2);
@@ -678,15 +682,15 @@ inline std::vector<lua_Integer> aut::getaudio(lua_State *L, const std::string &b
 }
 
 template<typename... Params>
-inline void aut::filter(lua_State *L, const std::string &name, Params... params) {
+inline void aut::filter(lua_State *L, std::string_view name, Params&&... params) {
     GetAULFunc(L, "filter");
-    size_t pushed_num = SetArgs(L, name, params...);
+    size_t pushed_num = SetArgs(L, name, std::forward<Params>(params)...);
     lua_call(L, pushed_num, 0);
     lua_pop(L, 1);
 }
 
-inline bool aut::copybuffer(lua_State *L, const std::string &dst,
-                            const std::string &src) {
+inline bool aut::copybuffer(lua_State *L, std::string_view dst,
+                            std::string_view src) {
     GetAULFunc(L, "copybuffer");
     size_t pushed_num = SetArgs(L, dst, src);
     lua_call(L, pushed_num, 1);
@@ -769,15 +773,15 @@ inline void aut::copypixel(lua_State *L, lua_Integer dst_x, lua_Integer dst_y,
     lua_pop(L, 1);
 }
 
-inline void aut::pixeloption(lua_State *L, const std::string &name,
-                             const std::string &value) {
+inline void aut::pixeloption(lua_State *L, std::string_view name,
+                             std::string_view value) {
     GetAULFunc(L, "pixeloption");
     size_t pushed_num = SetArgs(L, name, value);
     lua_call(L, pushed_num, 0);
     lua_pop(L, 1);
 }
 
-inline void aut::pixeloption(lua_State *L, const std::string &name, lua_Integer value) {
+inline void aut::pixeloption(lua_State *L, std::string_view name, lua_Integer value) {
     GetAULFunc(L, "pixeloption");
     size_t pushed_num = SetArgs(L, name, value);
     lua_call(L, pushed_num, 0);
@@ -786,15 +790,15 @@ inline void aut::pixeloption(lua_State *L, const std::string &name, lua_Integer
 
 template<typename... Params>
 inline void aut::getpixeldata(lua_State *L, PixelRGBA **out_data, Size2D *out_size,
-                              Params... params) {
-    getpixeldata(L, out_data, &out_size->w, &out_size->h, params...);
+                              Params&&... params) {
+    getpixeldata(L, out_data, &out_size->w, &out_size->h, std::forward<Params>(params)...);
 }
 
 template<typename... Params>
 inline void aut::getpixeldata(lua_State *L, PixelRGBA **out_data,
-                              uint *out_w, uint *out_h, Params... params) {
+                              uint *out_w, uint *out_h, Params&&... params) {
     GetAULFunc(L, "getpixeldata");
-    int pushed_num = SetArgs(L, params...);
+    int pushed_num = SetArgs(L, std::forward<Params>(params)...);
     lua_call(L, pushed_num, 3);
     *out_h = lua_tointeger(L, -1);
     *out_w = lua_tointeger(L, -2);